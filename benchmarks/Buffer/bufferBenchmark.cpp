@@ -0,0 +1,91 @@
+#include "yatta.hpp"
+#include <chrono>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::Buffer;
+using yatta::Threader;
+
+// Forward Declarations
+void Buffer_PatchBenchmark();
+void Buffer_HashBenchmark();
+
+/** Thread counts to measure, doubling up to the hardware limit. */
+std::vector<size_t> get_thread_counts() {
+    const auto maxThreads =
+        std::max<size_t>(std::thread::hardware_concurrency(), 1ULL);
+    std::vector<size_t> threadCounts;
+    for (size_t count = 1ULL; count < maxThreads; count *= 2ULL)
+        threadCounts.emplace_back(count);
+    threadCounts.emplace_back(maxThreads);
+    return threadCounts;
+}
+
+/** Time a benchmark for every thread count of the shared threader, printing
+the speedup over a single thread. */
+template <typename Benchmark>
+void run_benchmark(const char* name, const Benchmark& benchmark) {
+    std::cout << name << "\n";
+    double baseline(0.0);
+    for (const auto& threadCount : get_thread_counts()) {
+        Threader::SetSharedThreadCount(threadCount);
+        const auto start = std::chrono::steady_clock::now();
+        benchmark();
+        const auto end = std::chrono::steady_clock::now();
+        const double ms =
+            std::chrono::duration<double, std::milli>(end - start).count();
+        if (baseline == 0.0)
+            baseline = ms;
+        std::cout << "    threads: " << threadCount << "\ttime: " << ms
+                  << " ms\tspeedup: " << (baseline / ms) << "x\n";
+    }
+    Threader::SetSharedThreadCount(std::thread::hardware_concurrency());
+}
+
+int main() {
+    Buffer_PatchBenchmark();
+    Buffer_HashBenchmark();
+    exit(0);
+}
+
+void Buffer_PatchBenchmark() {
+    // A large source, with a target that shifts it and changes small regions
+    Buffer source(268435456ULL);
+    unsigned int seed(12345U);
+    for (auto& byte : source) {
+        seed = (seed * 1103515245U) + 12345U;
+        byte = static_cast<std::byte>(seed >> 16U);
+    }
+    Buffer target;
+    target.reserve(source.size() + 1ULL);
+    target.push_type(static_cast<std::byte>(1U));
+    target.push_raw(source.bytes(), source.size());
+    for (size_t x = 0ULL; x < target.size(); x += 65536ULL)
+        target[x] = static_cast<std::byte>(0U);
+    const auto diffBuffer = source.diff(target);
+    const auto patchedBuffer =
+        diffBuffer ? source.patch(*diffBuffer) : std::optional<Buffer>();
+    if (!patchedBuffer || patchedBuffer->hash() != target.hash()) {
+        std::cout << "Failed to diff and patch the benchmark buffers\n";
+        return;
+    }
+
+    // A single thread matches the serial path
+    run_benchmark("Patch (256 MiB)", [&]() {
+        [[maybe_unused]] const auto result = source.patch(*diffBuffer);
+    });
+}
+
+void Buffer_HashBenchmark() {
+    Buffer buffer(268435456ULL);
+    unsigned int seed(12345U);
+    for (auto& byte : buffer) {
+        seed = (seed * 1103515245U) + 12345U;
+        byte = static_cast<std::byte>(seed >> 16U);
+    }
+
+    // A single thread measures the SIMD kernel alone, more threads the tree
+    run_benchmark("Hash (256 MiB)", [&]() {
+        [[maybe_unused]] const auto result = buffer.hash();
+    });
+}
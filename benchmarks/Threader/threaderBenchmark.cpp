@@ -0,0 +1,75 @@
+#include "yatta.hpp"
+#include <chrono>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::Threader;
+
+// Forward Declarations
+void Threader_FlatBenchmark();
+void Threader_NestedBenchmark();
+
+/** Thread counts to measure, doubling up to the hardware limit. */
+std::vector<size_t> get_thread_counts() {
+    const auto maxThreads =
+        std::max<size_t>(std::thread::hardware_concurrency(), 1ULL);
+    std::vector<size_t> threadCounts;
+    for (size_t count = 1ULL; count < maxThreads; count *= 2ULL)
+        threadCounts.emplace_back(count);
+    threadCounts.emplace_back(maxThreads);
+    return threadCounts;
+}
+
+/** Simulate a tiny job's worth of work. */
+void do_work() noexcept {
+    volatile size_t value(0ULL);
+    for (size_t x = 0ULL; x < 2000ULL; ++x)
+        value = value + x;
+}
+
+/** Time a benchmark for every thread count, printing the speedup. */
+template <typename Benchmark>
+void run_benchmark(const char* name, const Benchmark& benchmark) {
+    std::cout << name << "\n";
+    double baseline(0.0);
+    for (const auto& threadCount : get_thread_counts()) {
+        const auto start = std::chrono::steady_clock::now();
+        benchmark(threadCount);
+        const auto end = std::chrono::steady_clock::now();
+        const double ms =
+            std::chrono::duration<double, std::milli>(end - start).count();
+        if (baseline == 0.0)
+            baseline = ms;
+        std::cout << "    threads: " << threadCount << "\ttime: " << ms
+                  << " ms\tspeedup: " << (baseline / ms) << "x\n";
+    }
+}
+
+int main() {
+    Threader_FlatBenchmark();
+    Threader_NestedBenchmark();
+    exit(0);
+}
+
+void Threader_FlatBenchmark() {
+    // Many tiny jobs added from outside of the threader
+    run_benchmark("Flat jobs (200000)", [](const size_t& threadCount) {
+        Threader threader(threadCount);
+        for (size_t x = 0ULL; x < 200000ULL; ++x)
+            threader.addJob([]() { do_work(); });
+        threader.wait();
+    });
+}
+
+void Threader_NestedBenchmark() {
+    // Jobs that fan out into many tiny jobs on their worker's own deque
+    run_benchmark("Nested jobs (256 x 1024)", [](const size_t& threadCount) {
+        Threader threader(threadCount);
+        for (size_t x = 0ULL; x < 256ULL; ++x)
+            threader.addJob([&threader]() {
+                for (size_t y = 0ULL; y < 1024ULL; ++y)
+                    threader.addJob([]() { do_work(); });
+            });
+        threader.wait();
+    });
+}
@@ -0,0 +1,77 @@
+#include "binaryIO.hpp"
+
+// Convenience Definitions
+using yatta::BinaryReader;
+using yatta::BinaryWriter;
+using yatta::MemoryRange;
+
+// BinaryReader (de)constructors
+
+BinaryReader::BinaryReader(const MemoryRange& memoryRange) noexcept
+    : m_data(memoryRange.bytes()), m_size(memoryRange.size()) {}
+
+// BinaryReader Public Inquiry Methods
+
+size_t BinaryReader::position() const noexcept { return m_position; }
+
+size_t BinaryReader::remaining() const noexcept { return m_size - m_position; }
+
+// BinaryReader Public Methods
+
+bool BinaryReader::read_string(std::string_view& value) noexcept {
+    // Ensure the characters and the trailing size fit
+    const auto start = m_position;
+    size_t length(0ULL);
+    if (!read(length) || length > remaining() ||
+        sizeof(size_t) > remaining() - length) {
+        m_position = start;
+        return false; // Failure
+    }
+    value = std::string_view(
+        reinterpret_cast<const char*>(&m_data[m_position]), length);
+    m_position += length + sizeof(size_t);
+    return true; // Success
+}
+
+bool BinaryReader::read_range(
+    const size_t& length, MemoryRange& value) noexcept {
+    if (length > remaining())
+        return false; // Failure
+    value = MemoryRange(length, const_cast<std::byte*>(&m_data[m_position]));
+    m_position += length;
+    return true; // Success
+}
+
+bool BinaryReader::skip(const size_t& length) noexcept {
+    if (length > remaining())
+        return false; // Failure
+    m_position += length;
+    return true; // Success
+}
+
+// BinaryWriter (de)constructors
+
+BinaryWriter::BinaryWriter(Buffer& buffer) noexcept : m_buffer(buffer) {}
+
+// BinaryWriter Public Methods
+
+void BinaryWriter::write_string(const std::string_view& value) {
+    const auto length = value.size();
+    auto* const data = grow(sizeof(size_t) + length + sizeof(size_t));
+    std::memcpy(data, &length, sizeof(size_t));
+    std::memcpy(&data[sizeof(size_t)], value.data(), length);
+    std::memcpy(&data[sizeof(size_t) + length], &length, sizeof(size_t));
+}
+
+void BinaryWriter::write_raw(const void* const dataPtr, const size_t& size) {
+    if (size != 0ULL)
+        std::memcpy(grow(size), dataPtr, size);
+}
+
+// BinaryWriter Private Methods
+
+std::byte* BinaryWriter::grow(const size_t& size) {
+    const auto byteIndex = m_buffer.size();
+    m_buffer.expand(byteIndex + size);
+    return &m_buffer.bytes()[byteIndex];
+}
@@ -0,0 +1,122 @@
+#pragma once
+#ifndef YATTA_BINARYIO_H
+#define YATTA_BINARYIO_H
+
+#include "buffer.hpp"
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace yatta {
+/** Reads records sequentially out of a memory range, advancing a cursor.
+Each read checks its bounds once for however many values it reads, failing
+rather than throwing if the range is too short. Strings and ranges are returned
+as views into the memory range, without copying. */
+class BinaryReader {
+    public:
+    // Public (de)Constructors
+    /** Construct a reader at the beginning of a memory range.
+    @param  memoryRange     the memory range to read from, which must outlive
+    this reader. */
+    explicit BinaryReader(const MemoryRange& memoryRange) noexcept;
+
+    // Public Inquiry Methods
+    /** Retrieve the number of bytes read so far.
+    @return                 the cursor's byte index. */
+    size_t position() const noexcept;
+    /** Retrieve the number of bytes left to read.
+    @return                 the number of bytes after the cursor. */
+    size_t remaining() const noexcept;
+
+    // Public Methods
+    /** Read a record of trivially copyable values, in order.
+    @tparam T               the value types (auto-deducible).
+    @param  values          references to the values to read into.
+    @return                 true on success, false if the range is too short. */
+    template <typename... T> bool read(T&... values) noexcept;
+    /** Read a string, written as its size, its characters, then its size again.
+    @param  value           reference to a view to point at the characters.
+    @return                 true on success, false if the range is too short. */
+    bool read_string(std::string_view& value) noexcept;
+    /** Read a range of bytes.
+    @param  length          the number of bytes to read.
+    @param  value           reference to a range to point at the bytes.
+    @return                 true on success, false if the range is too short. */
+    bool read_range(const size_t& length, MemoryRange& value) noexcept;
+    /** Skip over a number of bytes.
+    @param  length          the number of bytes to skip.
+    @return                 true on success, false if the range is too short. */
+    bool skip(const size_t& length) noexcept;
+
+    private:
+    // Private Attributes
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0ULL, m_position = 0ULL;
+};
+
+/** Appends records sequentially onto the end of a buffer.
+Each write grows the buffer once for however many values it writes. */
+class BinaryWriter {
+    public:
+    // Public (de)Constructors
+    /** Construct a writer appending onto a buffer.
+    @param  buffer          the buffer to write to, which must outlive this
+    writer. */
+    explicit BinaryWriter(Buffer& buffer) noexcept;
+
+    // Public Methods
+    /** Write a record of trivially copyable values, in order.
+    @tparam T               the value types (auto-deducible).
+    @param  values          the values to write. */
+    template <typename... T> void write(const T&... values);
+    /** Write a string as its size, its characters, then its size again.
+    @param  value           the string to write. */
+    void write_string(const std::string_view& value);
+    /** Write a range of bytes.
+    @param  dataPtr         pointer to the data to write.
+    @param  size            the number of bytes to write. */
+    void write_raw(const void* const dataPtr, const size_t& size);
+
+    private:
+    // Private Methods
+    /** Grow the buffer, returning a pointer to the bytes added. */
+    std::byte* grow(const size_t& size);
+
+    // Private Attributes
+    Buffer& m_buffer;
+};
+
+// Template Definitions
+
+template <typename... T> bool BinaryReader::read(T&... values) noexcept {
+    static_assert(
+        (std::is_trivially_copyable_v<T> && ...),
+        "only trivially copyable values can be read");
+    constexpr size_t recordSize = (sizeof(T) + ... + 0ULL);
+    if (recordSize > remaining())
+        return false; // Failure
+    (
+        [&](auto& value) noexcept {
+            std::memcpy(&value, &m_data[m_position], sizeof(value));
+            m_position += sizeof(value);
+        }(values),
+        ...);
+    return true; // Success
+}
+
+template <typename... T> void BinaryWriter::write(const T&... values) {
+    static_assert(
+        (std::is_trivially_copyable_v<T> && ...),
+        "only trivially copyable values can be written");
+    constexpr size_t recordSize = (sizeof(T) + ... + 0ULL);
+    auto* data = grow(recordSize);
+    (
+        [&](const auto& value) noexcept {
+            std::memcpy(data, &value, sizeof(value));
+            data += sizeof(value);
+        }(values),
+        ...);
+}
+}; // namespace yatta
+
+#endif // YATTA_BINARYIO_H
@@ -1,369 +1,497 @@
 #include "buffer.hpp"
+#include "binaryIO.hpp"
 #include "lz4/lz4.h"
 #include "threader.hpp"
 #include <algorithm>
+#include <atomic>
 #include <climits>
+#include <cstdint>
 #include <cstring>
+#include <limits>
+#include <memory_resource>
 #include <numeric>
 #include <vector>
 
 // Convenience Definitions
+using yatta::BinaryReader;
 using yatta::Buffer;
 using yatta::MemoryRange;
 using yatta::Threader;
 
-/** Data structures for buffer compression headers. */
+/** Data structures for legacy buffer compression headers. */
 struct CompressionHeader {
     char m_title[16ULL] = { '\0' };
     size_t m_uncompressedSize = 0ULL;
 };
+/** Data structures for block compression headers, followed by the end offset
+of every compressed block. */
+struct BlockCompressionHeader {
+    char m_title[16ULL] = { '\0' };
+    size_t m_uncompressedSize = 0ULL;
+    size_t m_blockSize = 0ULL;
+    size_t m_blockCount = 0ULL;
+};
+/** Data structures for legacy buffer differential headers. */
+struct LegacyDifferentialHeader {
+    char m_title[16ULL] = { '\0' };
+    size_t m_targetSize = 0ULL;
+};
 /** Data structures for buffer differential headers. */
 struct DifferentialHeader {
     char m_title[16ULL] = { '\0' };
+    size_t m_version = 0ULL;
     size_t m_targetSize = 0ULL;
 };
-/** Super-class for buffer diff instructions. */
-struct Differential_Instruction {
-    // Public Default Members
-    virtual ~Differential_Instruction() = default;
-    Differential_Instruction() = default;
-    Differential_Instruction(const Differential_Instruction& other) = default;
-    Differential_Instruction(Differential_Instruction&& other) = default;
-    Differential_Instruction&
-    operator=(const Differential_Instruction& other) = default;
-    Differential_Instruction&
-    operator=(Differential_Instruction&& other) = default;
-    // Interface Declaration
-    /** Retrieve the byte-size of this instruction. */
-    [[nodiscard]] virtual size_t size() const noexcept = 0;
-    /** Execute this instruction. */
-    virtual void
-    execute(Buffer& bufferNew, const MemoryRange& bufferOld) const = 0;
-    /** Write-out this instruction to a buffer. */
-    virtual void write(Buffer& outputBuffer) const = 0;
-    /** Read-in this instruction from a buffer. */
-    virtual void read(const Buffer& inputBuffer, size_t& byteIndex) = 0;
-
-    // Attributes
-    size_t m_index = 0ULL;
+/** The current version of the patch instruction format. */
+constexpr size_t DiffVersion = 2ULL;
+/** The kinds of diff instructions. */
+enum class Opcode : char {
+    /** Copy an existing segment of the source. */
+    Copy = 'C',
+    /** Insert an entirely new data segment. */
+    Insert = 'I',
+    /** Fill a segment with a repeating value. */
+    Repeat = 'R',
+    /** Add byte-wise differences onto a segment of the source. */
+    Add = 'A'
 };
-/** Diff instruction to copy an existing segment. */
-struct Copy_Instruction final : public Differential_Instruction {
-    // Interface Implementation
-    [[nodiscard]] size_t size() const noexcept final {
-        return static_cast<size_t>(sizeof(char) + (sizeof(size_t) * 3ULL));
-    }
-    void execute(Buffer& bufferNew, const MemoryRange& bufferOld) const final {
-        const auto old_subRange =
-            bufferOld.subrange(m_beginRead, m_endRead - m_beginRead);
-        std::copy(
-            old_subRange.cbegin(), old_subRange.cend(), &bufferNew[m_index]);
-    }
-    void write(Buffer& outputBuffer) const final {
-        // Write Attributes
-        outputBuffer.push_type('C');
-        outputBuffer.push_type(m_index);
-        outputBuffer.push_type(m_beginRead);
-        outputBuffer.push_type(m_endRead);
-    }
-    void read(const Buffer& inputBuffer, size_t& byteIndex) final {
-        // Read Attributes
-        // Type already read
-        inputBuffer.out_type(m_index, byteIndex);
-        byteIndex += sizeof(size_t);
-        inputBuffer.out_type(m_beginRead, byteIndex);
-        byteIndex += sizeof(size_t);
-        inputBuffer.out_type(m_endRead, byteIndex);
-        byteIndex += sizeof(size_t);
+/** A set of diff instructions, held as flat parallel arrays.
+Instructions own no data: copies reference the source range, and insertions
+reference a payload range (the target while diffing, the patch while patching)
+by offset. Additions reference both, their differences being taken from the
+target while diffing. */
+struct InstructionList {
+    // Public (de)Constructors
+    /** Construct an empty list, allocating from the specified resource. */
+    explicit InstructionList(
+        std::pmr::memory_resource* const resource =
+            std::pmr::get_default_resource())
+        : m_opcodes(resource), m_indices(resource), m_offsets(resource),
+          m_lengths(resource), m_values(resource), m_payloads(resource) {}
+
+    // Public Methods
+    /** Retrieve the number of instructions held. */
+    [[nodiscard]] size_t size() const noexcept { return m_opcodes.size(); }
+    /** Append an instruction. */
+    void emplace(
+        const Opcode& opcode, const size_t& index, const size_t& offset,
+        const size_t& length, const std::byte& value = std::byte(0),
+        const size_t& payload = 0ULL) {
+        m_opcodes.emplace_back(opcode);
+        m_indices.emplace_back(index);
+        m_offsets.emplace_back(offset);
+        m_lengths.emplace_back(length);
+        m_values.emplace_back(value);
+        m_payloads.emplace_back(payload);
+    }
+    /** Append an instruction from another list. */
+    void emplace(const InstructionList& other, const size_t& x) {
+        emplace(
+            other.m_opcodes[x], other.m_indices[x], other.m_offsets[x],
+            other.m_lengths[x], other.m_values[x], other.m_payloads[x]);
     }
 
     // Public Attributes
-    size_t m_beginRead = 0ULL, m_endRead = 0ULL;
+    /** The kind of each instruction. */
+    std::pmr::vector<Opcode> m_opcodes;
+    /** Where each instruction writes to in the target. */
+    std::pmr::vector<size_t> m_indices;
+    /** Where copies and additions read from in the source, or insertions in
+    the payload. */
+    std::pmr::vector<size_t> m_offsets;
+    /** How many bytes each instruction writes. */
+    std::pmr::vector<size_t> m_lengths;
+    /** The value each repeat fills with. */
+    std::pmr::vector<std::byte> m_values;
+    /** Where additions read their differences from in the payload. */
+    std::pmr::vector<size_t> m_payloads;
 };
-/** Diff instruction for inserting an entirely new data segment. */
-struct Insert_Instruction final : public Differential_Instruction {
-    // Interface Implementation
-    [[nodiscard]] size_t size() const noexcept final {
-        return static_cast<size_t>(
-            sizeof(char) + (sizeof(size_t) * 2ULL) +
-            (sizeof(char) * m_newData.size()));
-    }
-    void execute(Buffer& bufferNew, const MemoryRange& /*unused*/) const final {
-        std::copy(m_newData.cbegin(), m_newData.cend(), &bufferNew[m_index]);
-    }
-    void write(Buffer& outputBuffer) const final {
-        // Write Attributes
-        outputBuffer.push_type('I');
-        outputBuffer.push_type(m_index);
-        const auto length = m_newData.size();
-        outputBuffer.push_type(length);
-        if (length != 0U)
-            outputBuffer.push_raw(m_newData.data(), length);
-    }
-    void read(const Buffer& inputBuffer, size_t& byteIndex) final {
-        // Read Attributes
-        // Type already read
-        inputBuffer.out_type(m_index, byteIndex);
-        byteIndex += sizeof(size_t);
-        size_t length(0ULL);
-        inputBuffer.out_type(length, byteIndex);
-        byteIndex += sizeof(size_t);
-        if (length != 0ULL) {
-            m_newData.resize(length);
-            inputBuffer.out_raw(m_newData.data(), length, byteIndex);
-            byteIndex += sizeof(char) * length;
-        }
-    }
-
-    // Attributes
-    std::vector<std::byte> m_newData;
+/** A single diff instruction. */
+struct Instruction {
+    Opcode m_opcode = Opcode::Copy;
+    size_t m_index = 0ULL, m_offset = 0ULL, m_length = 0ULL, m_payload = 0ULL;
+    std::byte m_value{ 0 };
 };
-/** Diff instruction for a repeating value. */
-struct Repeat_Instruction final : public Differential_Instruction {
-    // Interface Implementation
-    [[nodiscard]] size_t size() const noexcept final {
-        return static_cast<size_t>(
-            sizeof(char) + (sizeof(size_t) * 2ULL) + sizeof(char));
-    }
-    void execute(Buffer& bufferNew, const MemoryRange& /*unused*/) const final {
-        std::fill(
-            &bufferNew[m_index],
-            &bufferNew[std::min(m_index + m_amount, bufferNew.size())],
-            m_value);
-    }
-    void write(Buffer& outputBuffer) const final {
-        // Write Attributes
-        outputBuffer.push_type('R');
-        // Write Index
-        outputBuffer.push_type(m_index);
-        // Write Amount
-        outputBuffer.push_type(m_amount);
-        // Write Value
-        outputBuffer.push_type(m_value);
-    }
-    void read(const Buffer& inputBuffer, size_t& byteIndex) final {
-        // Read Attributes
-        // Type already read
-        inputBuffer.out_type(m_index, byteIndex);
-        byteIndex += sizeof(size_t);
-        inputBuffer.out_type(m_amount, byteIndex);
-        byteIndex += sizeof(size_t);
-        inputBuffer.out_type(m_value, byteIndex);
-        byteIndex += sizeof(char);
-    }
-
-    // Attributes
-    size_t m_amount = 0ULL;
-    std::byte m_value = static_cast<std::byte>(0);
+/** The positions diff instructions are delta-encoded against. */
+struct InstructionCursor {
+    size_t m_lastIndex = 0ULL, m_lastRead = 0ULL;
 };
-/** Defines a matching region. */
+/** Defines a matching region, which may differ in places if approximate. */
 struct MatchInfo {
     size_t length = 0ULL, start1 = 0ULL, start2 = 0ULL;
+    bool approximate = false;
 };
-/** Defines a window. */
-struct WindowInfo {
-    size_t windowSize = 0ULL, indexA = 0ULL, indexB = 0ULL;
-};
+/** Pairs a block's rolling hash with its offset in the source range. */
+using BlockIndex = std::pmr::vector<std::pair<size_t, size_t>>;
+/** A set of matching regions, ordered by their target position. */
+using MatchList = std::pmr::vector<MatchInfo>;
+
+/** Byte length of the independently compressed blocks. */
+constexpr size_t CompressionBlockSize = 1048576ULL;
+/** Byte length of the target stripes patched in parallel. */
+constexpr size_t PatchStripeSize = 1048576ULL;
+/** Minimum byte length of the trailing literals in an LZ4 block. */
+constexpr size_t LZ4LastLiterals = 5ULL;
+/** Minimum distance from the end of an LZ4 block for a match to start at. */
+constexpr size_t LZ4MatchLimit = 12ULL;
+/** Maximum distance an LZ4 match may reach back, also used as a mask. */
+constexpr size_t LZ4MaxOffset = 65535ULL;
+/** Maximum number of bytes each byte of an LZ4 block can decompress into. */
+constexpr size_t LZ4MaxRatio = 255ULL;
+/** Number of bits indexing the high compression hash table. */
+constexpr uint32_t HCHashBits = 15U;
+/** Byte length of the source blocks indexed by the rolling hash. */
+constexpr size_t BlockSize = 32ULL;
+/** Byte length of the target region scanned by a single job. */
+constexpr size_t ScanSize = 262144ULL;
+/** Maximum number of source blocks to compare per hash collision. */
+constexpr size_t MaxCandidates = 8ULL;
+/** Maximum byte length of differences an approximate match may skip over. */
+constexpr size_t ApproximateGap = 64ULL;
+/** Maximum byte length of a single insertion instruction. */
+constexpr size_t MaxInsertSize = 4096ULL;
+/** Multiplier for the polynomial rolling hash. */
+constexpr size_t HashPrime = 1099511628211ULL;
+/** Multiplier for removing the oldest byte from a rolling hash. */
+constexpr size_t HashOutFactor = [] {
+    size_t factor(1ULL);
+    for (size_t x = 1ULL; x < BlockSize; ++x)
+        factor *= HashPrime;
+    return factor;
+}();
 
 // Private Static Methods
 
-/** Find matching regions for 2 given ranges. */
-auto find_matching_regions(
-    const MemoryRange& rangeA, const MemoryRange& rangeB) {
-    std::vector<MatchInfo> bestMatch;
-    size_t largestMatch(0ULL);
-
-    // Algorithm Overview
-    // For each element in Range A, compare from element index -> end
-    // against entire Range B
-    std::for_each(
-        rangeA.cbegin_t<size_t>(), rangeA.cend_t<size_t>(),
-        [&](const size_t& elementA) {
-            size_t matchCount(0ULL);
-            size_t sumMatches(0ULL);
-            std::vector<MatchInfo> matches;
-            const size_t index_8byte =
-                &elementA - reinterpret_cast<const size_t*>(rangeA.cbegin());
-            const size_t index_byte = index_8byte * sizeof(size_t);
-            const auto subRangeA =
-                rangeA.subrange(index_byte, rangeA.size() - index_byte);
-            const auto length = std::min(subRangeA.size(), rangeB.size());
-
-            // Iterate through {subRangeA and rangeB} 8 bytes at a time
-            // Take note of matches >= 32 bytes in a row
-            for (size_t ind = 0ULL; ind < length; ind += 8ULL) {
-                const auto& byteA =
-                    *reinterpret_cast<const size_t*>(&subRangeA[ind]);
-                const auto& byteB =
-                    *reinterpret_cast<const size_t*>(&rangeB[ind]);
-                if (byteA == byteB)
-                    ++matchCount;
-                else {
-                    if (matchCount >= 4ULL) {
-                        const auto matchLength = matchCount * sizeof(size_t);
-                        matches.emplace_back(MatchInfo{
-                            matchLength, ind + index_byte - matchLength,
-                            ind - matchLength });
-                        sumMatches += matchCount;
-                    }
-                    matchCount = 0ULL;
-                }
-            }
-
-            if (sumMatches > largestMatch) {
-                largestMatch = sumMatches;
-                bestMatch = matches;
-            }
-        });
-    return bestMatch;
+/** Hash a full block of bytes. */
+size_t hash_block(const std::byte* const data) noexcept {
+    size_t value(0ULL);
+    for (size_t x = 0ULL; x < BlockSize; ++x)
+        value = (value * HashPrime) + static_cast<size_t>(data[x]);
+    return value;
 }
 
-/** Split 2 ranges and find their matching ranges. */
-auto split_and_match_ranges(
-    const MemoryRange& rangeA, const MemoryRange& rangeB, size_t& indexA,
-    size_t& indexB) {
-    const auto sizeA = rangeA.size();
-    const auto sizeB = rangeB.size();
-    std::mutex matchMutex;
-    std::vector<std::pair<WindowInfo, std::vector<MatchInfo>>> matchingRegions;
-
-    Threader threader;
-    while (indexA < sizeA && indexB < sizeB) {
-        const auto windowSize = std::min(
-            static_cast<size_t>(4096ULL),
-            std::min(sizeA - indexA, sizeB - indexB));
-
-        threader.addJob([&, windowSize, indexA, indexB]() {
-            const auto windowA = rangeA.subrange(indexA, windowSize);
-            const auto windowB = rangeB.subrange(indexB, windowSize);
-            auto matches = find_matching_regions(windowA, windowB);
-            for (auto& matchInfo : matches) {
-                matchInfo.start1 += indexA;
-                matchInfo.start2 += indexB;
-            }
-
-            std::unique_lock<std::mutex> writeGuard(matchMutex);
-            matchingRegions.emplace_back(
-                WindowInfo{ windowSize, indexA, indexB }, matches);
-        });
+/** Slide a block hash forward by one byte. */
+size_t roll_hash(
+    const size_t& value, const std::byte& byteOut,
+    const std::byte& byteIn) noexcept {
+    return ((value - (static_cast<size_t>(byteOut) * HashOutFactor)) *
+            HashPrime) +
+           static_cast<size_t>(byteIn);
+}
 
-        // increment
-        indexA += windowSize;
-        indexB += windowSize;
+/** Count how many bytes match between 2 pointers, up to a maximum. */
+size_t count_matching(
+    const std::byte* const dataA, const std::byte* const dataB,
+    const size_t& maxLength) noexcept {
+    // Compare 8-byte-wise
+    size_t length(0ULL);
+    for (; length + 8ULL <= maxLength; length += 8ULL) {
+        size_t valueA(0ULL);
+        size_t valueB(0ULL);
+        std::memcpy(&valueA, &dataA[length], sizeof(size_t));
+        std::memcpy(&valueB, &dataB[length], sizeof(size_t));
+        if (valueA != valueB)
+            break;
     }
 
-    // Wait for jobs to finish
-    while (!threader.isFinished())
-        continue;
+    // Compare 1-byte-wise
+    while (length < maxLength && dataA[length] == dataB[length])
+        ++length;
+    return length;
+}
 
-    return matchingRegions;
+/** Index every whole block in a range by its hash. */
+BlockIndex
+index_blocks(const MemoryRange& range, std::pmr::memory_resource* resource) {
+    const auto blockCount = range.size() / BlockSize;
+    const auto* const bytes = range.bytes();
+    BlockIndex index(blockCount, resource);
+    Threader::GetShared().parallel_for(0ULL, blockCount, [&](const size_t& x) {
+        index[x] = { hash_block(&bytes[x * BlockSize]), x * BlockSize };
+    });
+
+    // Sort by hash, then by offset, so lookups are deterministic
+    std::sort(index.begin(), index.end());
+    return index;
 }
 
-/** Generate and emplace a new insertion instruction. */
-void emplace_insertion(
-    const size_t& index, const MemoryRange& range, std::mutex& mutex,
-    std::vector<std::unique_ptr<Differential_Instruction>>& instructions) {
-    // Make an instruction from input arguments
-    auto inst = std::make_unique<Insert_Instruction>();
-    inst->m_index = index;
-    inst->m_newData.resize(range.size());
+/** Find source blocks matching a region of the target range. */
+auto find_block_matches(
+    const MemoryRange& rangeA, const MemoryRange& rangeB,
+    const BlockIndex& index, const size_t& begin, const size_t& end) {
+    std::vector<MatchInfo> matches;
+    const auto sizeA = rangeA.size();
+    const auto sizeB = rangeB.size();
+    const auto* const bytesA = rangeA.bytes();
+    const auto* const bytesB = rangeB.bytes();
 
-    // Copy buffer data
-    std::copy(range.cbegin(), range.cend(), inst->m_newData.begin());
+    // Algorithm Overview
+    // Roll a hash over every block-sized window of the target region, look
+    // it up in the source index, and extend verified matches both ways
+    size_t lastMatchEnd(begin);
+    size_t position(begin);
+    size_t hash(0ULL);
+    bool hashValid(false);
+    while (position < end && position + BlockSize <= sizeB) {
+        if (!hashValid) {
+            hash = hash_block(&bytesB[position]);
+            hashValid = true;
+        }
 
-    // Emplace instruction back in vector
-    std::unique_lock<std::mutex> writeGuard(mutex);
-    instructions.emplace_back(std::move(inst));
-}
+        // Keep the longest match amongst the candidates sharing this hash
+        MatchInfo bestMatch;
+        auto candidate = std::lower_bound(
+            index.cbegin(), index.cend(), hash,
+            [](const auto& entry, const size_t& value) noexcept {
+                return entry.first < value;
+            });
+        for (size_t count = 0ULL; candidate != index.cend() &&
+                                  candidate->first == hash &&
+                                  count < MaxCandidates;
+             ++candidate, ++count) {
+            const auto offset = candidate->second;
+            const auto length = count_matching(
+                &bytesA[offset], &bytesB[position],
+                std::min(sizeA - offset, sizeB - position));
+            if (length >= BlockSize && length > bestMatch.length)
+                bestMatch = MatchInfo{ length, offset, position };
+        }
 
-/** Generate and emplace a new copy instruction. */
-void emplace_copy(
-    const size_t& index, const size_t& beginRead, const size_t& endRead,
-    std::mutex& mutex,
-    std::vector<std::unique_ptr<Differential_Instruction>>& instructions) {
-    // Make an instruction from input arguments
-    auto inst = std::make_unique<Copy_Instruction>();
-    inst->m_index = index;
-    inst->m_beginRead = beginRead;
-    inst->m_endRead = endRead;
+        // No match, slide forward a single byte
+        if (bestMatch.length == 0ULL) {
+            if (position + BlockSize < sizeB)
+                hash = roll_hash(
+                    hash, bytesB[position], bytesB[position + BlockSize]);
+            ++position;
+            continue;
+        }
 
-    // Emplace instruction back in vector
-    std::unique_lock<std::mutex> writeGuard(mutex);
-    instructions.emplace_back(std::move(inst));
+        // Extend the match backwards into any pending unmatched data
+        while (bestMatch.start2 > lastMatchEnd && bestMatch.start1 > 0ULL &&
+               bytesA[bestMatch.start1 - 1ULL] ==
+                   bytesB[bestMatch.start2 - 1ULL]) {
+            --bestMatch.start1;
+            --bestMatch.start2;
+            ++bestMatch.length;
+        }
+        matches.emplace_back(bestMatch);
+        position = lastMatchEnd = bestMatch.start2 + bestMatch.length;
+        hashValid = false;
+    }
+    return matches;
 }
 
-/** Generate a diff instruction set from 2 ranges. */
-auto generate_instructions(
-    const MemoryRange& rangeA, const MemoryRange& rangeB) {
-    std::vector<std::unique_ptr<Differential_Instruction>> instructions;
-    std::mutex instructionMutex;
-    Threader threader;
-    size_t indexA(0ULL);
-    size_t indexB(0ULL);
-    for (const auto& matchRegion :
-         split_and_match_ranges(rangeA, rangeB, indexA, indexB)) {
-        threader.addJob([&, matchRegion]() {
-            const auto& [windowInfo, matches] = matchRegion;
-            size_t lastMatchEnd(windowInfo.indexB);
-            for (auto& matchInfo : matches) {
-                // INSERT data from end of the last match until now
-                const auto newDataLength = matchInfo.start2 - lastMatchEnd;
-                if (newDataLength > 0ULL)
-                    emplace_insertion(
-                        lastMatchEnd,
-                        rangeB.subrange(lastMatchEnd, newDataLength),
-                        instructionMutex, instructions);
-
-                // COPY data in matching region
-                emplace_copy(
-                    matchInfo.start2, matchInfo.start1,
-                    matchInfo.start1 + matchInfo.length, instructionMutex,
-                    instructions);
-                lastMatchEnd = matchInfo.start2 + matchInfo.length;
+/** Find matching regions for 2 given ranges. */
+auto find_matching_regions(
+    const MemoryRange& rangeA, const MemoryRange& rangeB,
+    std::pmr::memory_resource* resource) {
+    // Index the source range once, then scan target regions in parallel
+    const auto index = index_blocks(rangeA, resource);
+    const auto sizeB = rangeB.size();
+    const auto jobCount = (sizeB + ScanSize - 1ULL) / ScanSize;
+    std::vector<std::vector<MatchInfo>> jobMatches(jobCount);
+    Threader::GetShared().parallel_for(
+        0ULL, jobCount,
+        [&](const size_t& job) {
+            const auto begin = job * ScanSize;
+            const auto end = std::min(begin + ScanSize, sizeB);
+            jobMatches[job] =
+                find_block_matches(rangeA, rangeB, index, begin, end);
+        },
+        1ULL);
+
+    // Join the regions in order, trimming matches that run into each other
+    MatchList matches(resource);
+    size_t lastMatchEnd(0ULL);
+    for (const auto& regionMatches : jobMatches) {
+        for (auto matchInfo : regionMatches) {
+            if (matchInfo.start2 < lastMatchEnd) {
+                const auto overlap = lastMatchEnd - matchInfo.start2;
+                if (matchInfo.length < overlap + BlockSize)
+                    continue;
+                matchInfo.start1 += overlap;
+                matchInfo.start2 += overlap;
+                matchInfo.length -= overlap;
             }
+            matches.emplace_back(matchInfo);
+            lastMatchEnd = matchInfo.start2 + matchInfo.length;
+        }
+    }
+    return matches;
+}
 
-            // INSERT data from end of the last match until window end
-            const auto newDataLength =
-                (windowInfo.indexB + windowInfo.windowSize) - lastMatchEnd;
-            if (newDataLength > 0ULL)
-                emplace_insertion(
-                    lastMatchEnd, rangeB.subrange(lastMatchEnd, newDataLength),
-                    instructionMutex, instructions);
-        });
+/** Build a suffix array over a range, by prefix doubling. */
+std::pmr::vector<size_t> build_suffix_array(
+    const MemoryRange& range, std::pmr::memory_resource* resource) {
+    const auto size = range.size();
+    const auto* const bytes = range.bytes();
+    std::pmr::vector<size_t> suffixes(size, resource);
+    std::pmr::vector<size_t> ranks(size, resource);
+    std::pmr::vector<size_t> nextRanks(size, resource);
+    std::iota(suffixes.begin(), suffixes.end(), 0ULL);
+    for (size_t x = 0ULL; x < size; ++x)
+        ranks[x] = static_cast<size_t>(bytes[x]);
+
+    // Each pass orders suffixes by twice as many leading bytes as the last
+    for (size_t offset = 1ULL; size > 1ULL; offset *= 2ULL) {
+        const auto rank_after = [&](const size_t& suffix) noexcept {
+            return suffix + offset < size ? ranks[suffix + offset] + 1ULL
+                                          : 0ULL;
+        };
+        const auto compare = [&](const size_t& a, const size_t& b) noexcept {
+            if (ranks[a] != ranks[b])
+                return ranks[a] < ranks[b];
+            return rank_after(a) < rank_after(b);
+        };
+        std::sort(suffixes.begin(), suffixes.end(), compare);
+
+        // Re-rank, quitting once every suffix is unique
+        nextRanks[suffixes[0]] = 0ULL;
+        for (size_t x = 1ULL; x < size; ++x)
+            nextRanks[suffixes[x]] =
+                nextRanks[suffixes[x - 1ULL]] +
+                (compare(suffixes[x - 1ULL], suffixes[x]) ? 1ULL : 0ULL);
+        std::swap(ranks, nextRanks);
+        if (ranks[suffixes[size - 1ULL]] == size - 1ULL)
+            break;
     }
+    return suffixes;
+}
 
-    // INSERT data from end of the last window until the end of the buffer range
-    if (const auto sizeB = rangeB.size(); indexB < sizeB)
-        emplace_insertion(
-            indexB, rangeB.subrange(indexB, sizeB - indexB), instructionMutex,
-            instructions);
+/** Find the longest source match for the target data at a given position. */
+MatchInfo find_longest_match(
+    const std::pmr::vector<size_t>& suffixes, const MemoryRange& rangeA,
+    const MemoryRange& rangeB, const size_t& position) {
+    const auto sizeA = rangeA.size();
+    const auto* const bytesA = rangeA.bytes();
+    const auto* const target = &rangeB.bytes()[position];
+    const auto targetLength = rangeB.size() - position;
+
+    // The longest match neighbours the target's sorted insertion point
+    const auto insertion = std::lower_bound(
+        suffixes.cbegin(), suffixes.cend(), 0ULL,
+        [&](const size_t& suffix, const size_t& /*unused*/) noexcept {
+            const auto length = std::min(sizeA - suffix, targetLength);
+            const auto result =
+                std::memcmp(&bytesA[suffix], target, length);
+            return result < 0 || (result == 0 && length < targetLength);
+        });
+    MatchInfo bestMatch;
+    const auto test_suffix = [&](const size_t& suffix) noexcept {
+        const auto length = count_matching(
+            &bytesA[suffix], target, std::min(sizeA - suffix, targetLength));
+        if (length > bestMatch.length)
+            bestMatch = MatchInfo{ length, suffix, position };
+    };
+    if (insertion != suffixes.cend())
+        test_suffix(*insertion);
+    if (insertion != suffixes.cbegin())
+        test_suffix(*std::prev(insertion));
+    return bestMatch;
+}
 
-    // Wait for jobs to finish
-    while (!threader.isFinished())
-        continue;
+/** Extend a match through small differences, as an approximate match whose
+differences are added onto the source. Returns the target position the
+extension ended at. */
+size_t extend_approximate_match(
+    const MemoryRange& rangeA, const MemoryRange& rangeB,
+    const MatchInfo& matchInfo, MatchList& matches) {
+    const auto* const bytesA = rangeA.bytes();
+    const auto* const bytesB = rangeB.bytes();
+    const auto startA = matchInfo.start1 + matchInfo.length;
+    const auto startB = matchInfo.start2 + matchInfo.length;
+    const auto maxLength =
+        std::min(rangeA.size() - startA, rangeB.size() - startB);
+
+    // Keep extending while matching bytes outnumber differing ones
+    std::ptrdiff_t score(0);
+    std::ptrdiff_t bestScore(0);
+    size_t bestLength(0ULL);
+    for (size_t x = 0ULL; x < maxLength; ++x) {
+        score += bytesA[startA + x] == bytesB[startB + x] ? 1 : -1;
+        if (score > bestScore) {
+            bestScore = score;
+            bestLength = x + 1ULL;
+        }
+        // Give up after a long stretch of differences
+        else if ((x + 1ULL) - bestLength > ApproximateGap)
+            break;
+    }
 
-    return instructions;
+    if (bestLength > 0ULL)
+        matches.emplace_back(MatchInfo{ bestLength, startA, startB, true });
+    return startB + bestLength;
 }
 
-/** Retrieve insertion instructions larger than 36 bytes. */
-std::vector<Insert_Instruction*> get_large_insertions(
-    std::vector<std::unique_ptr<Differential_Instruction>>& instructions) {
-    // Create a vector large enough for worst-case-scenario
-    std::vector<Insert_Instruction*> largeInsertions;
-    largeInsertions.reserve(instructions.size());
+/** Find matching regions for 2 given ranges, using a suffix array. */
+auto find_suffix_regions(
+    const MemoryRange& rangeA, const MemoryRange& rangeB,
+    const bool& approximate, std::pmr::memory_resource* resource) {
+    MatchList matches(resource);
+    if (rangeA.empty())
+        return matches;
 
-    // Find all valid insertion instructions
-    for (const auto& instruction : instructions) {
-        // We only care about repeats larger than 36 bytes.
-        auto inst = dynamic_cast<Insert_Instruction*>(instruction.get());
-        if (inst == nullptr || inst->m_newData.size() <= 36ULL)
+    // Greedily take the longest match available at each target position
+    const auto suffixes = build_suffix_array(rangeA, resource);
+    const auto sizeB = rangeB.size();
+    size_t position(0ULL);
+    while (position < sizeB) {
+        const auto matchInfo =
+            find_longest_match(suffixes, rangeA, rangeB, position);
+        if (matchInfo.length < BlockSize) {
+            ++position;
             continue;
+        }
+        matches.emplace_back(matchInfo);
+        position = matchInfo.start2 + matchInfo.length;
+        if (approximate)
+            position =
+                extend_approximate_match(rangeA, rangeB, matchInfo, matches);
+    }
+    return matches;
+}
+
+/** Generate and emplace new insertion instructions. */
+void emplace_insertion(
+    const size_t& index, const size_t& length, InstructionList& instructions) {
+    // Split large insertions so they can be analyzed in parallel later
+    for (size_t offset = 0ULL; offset < length; offset += MaxInsertSize)
+        instructions.emplace(
+            Opcode::Insert, index + offset, index + offset,
+            std::min(MaxInsertSize, length - offset));
+}
 
-        // Use this instruction
-        largeInsertions.emplace_back(inst);
+/** Generate a diff instruction set from 2 ranges. */
+auto generate_instructions(
+    const MemoryRange& rangeA, const MemoryRange& rangeB,
+    const yatta::DiffOptions& options) {
+    const auto matches =
+        options.m_method == yatta::DiffOptions::Method::SuffixArray
+            ? find_suffix_regions(
+                  rangeA, rangeB, options.m_approximate, options.m_resource)
+            : find_matching_regions(rangeA, rangeB, options.m_resource);
+
+    InstructionList instructions(options.m_resource);
+    size_t lastMatchEnd(0ULL);
+    for (const auto& matchInfo : matches) {
+        // INSERT data from end of the last match until now
+        const auto newDataLength = matchInfo.start2 - lastMatchEnd;
+        if (newDataLength > 0ULL)
+            emplace_insertion(lastMatchEnd, newDataLength, instructions);
+
+        // COPY data in matching region, or ADD onto it if approximate
+        instructions.emplace(
+            matchInfo.approximate ? Opcode::Add : Opcode::Copy,
+            matchInfo.start2, matchInfo.start1, matchInfo.length, std::byte(0),
+            matchInfo.start2);
+        lastMatchEnd = matchInfo.start2 + matchInfo.length;
     }
 
-    return largeInsertions;
+    // INSERT data from end of the last match until the end of the buffer range
+    if (const auto sizeB = rangeB.size(); lastMatchEnd < sizeB)
+        emplace_insertion(lastMatchEnd, sizeB - lastMatchEnd, instructions);
+
+    return instructions;
 }
 
 /** Find the last common value in a repeating series. */
@@ -391,104 +519,777 @@ find_last_in_series(const std::byte& value, const MemoryRange& range) noexcept {
     return index;
 }
 
-/** Split an insertion instruction into two insertions and a repeat. */
+/** Split an insertion instruction into insertions and repeats, wherever it
+repeats a value for more than 36 bytes. */
 void split_insertion(
-    Insert_Instruction* const& inst, const size_t& startIndex,
-    const size_t& endIndex, const std::byte& value_at_x,
-    std::vector<std::unique_ptr<Differential_Instruction>>& instructions,
-    std::mutex& mutex) {
-    // Keep data up until region where repeats occur
-    Insert_Instruction instBefore;
-    instBefore.m_index = inst->m_index;
-    instBefore.m_newData.resize(startIndex);
-    std::copy(
-        inst->m_newData.data(), inst->m_newData.data() + startIndex,
-        instBefore.m_newData.data());
+    const InstructionList& instructions, const size_t& x,
+    const MemoryRange& payload, InstructionList& newInstructions) {
+    const auto index = instructions.m_indices[x];
+    const auto offset = instructions.m_offsets[x];
+    const auto length = instructions.m_lengths[x];
+    const auto data = payload.subrange(offset, length);
+    size_t anchor(0ULL);
+    size_t position(0ULL);
+    while (position + 36ULL < length) {
+        // Find how far this value is repeated for
+        const auto& value = data[position];
+        const auto runEnd =
+            position + find_last_in_series(
+                           value, data.subrange(position, length - position));
+
+        // Skip over repeats less than 36 bytes
+        if ((runEnd - position) <= 36ULL) {
+            position = runEnd;
+            continue;
+        }
 
-    // Generate new Repeat Instruction
-    Repeat_Instruction instRepeat;
-    const auto length = endIndex - startIndex;
-    instRepeat.m_index = inst->m_index + startIndex;
-    instRepeat.m_value = value_at_x;
-    instRepeat.m_amount = length;
+        // Keep data up until the repeats, then replace them
+        if (position > anchor)
+            newInstructions.emplace(
+                Opcode::Insert, index + anchor, offset + anchor,
+                position - anchor);
+        newInstructions.emplace(
+            Opcode::Repeat, index + position, 0ULL, runEnd - position, value);
+        position = anchor = runEnd;
+    }
 
     // Retain remainder of insertion data
-    const auto size = inst->m_newData.size();
-    inst->m_index = inst->m_index + startIndex + length;
-    std::memmove(
-        &inst->m_newData[0], &inst->m_newData[endIndex], size - endIndex);
-    inst->m_newData.resize(size - endIndex);
-
-    std::unique_lock<std::mutex> writeGuard(mutex);
-    instructions.emplace_back(
-        std::make_unique<Insert_Instruction>(std::move(instBefore)));
-    instructions.emplace_back(
-        std::make_unique<Repeat_Instruction>(std::move(instRepeat)));
+    if (anchor < length)
+        newInstructions.emplace(
+            Opcode::Insert, index + anchor, offset + anchor, length - anchor);
 }
 
 /** Replace repeating segments in insertion instructions with repeats. */
 void insertions_to_repeats(
-    std::vector<std::unique_ptr<Differential_Instruction>>& baseInstructions) {
-    // Analyze segments larger than 36 bytes in a separate thread
-    Threader threader;
-    std::mutex instructionMutex;
-    std::vector<std::unique_ptr<Differential_Instruction>> newInstructions;
-    for (const auto& inst : get_large_insertions(baseInstructions)) {
-        threader.addJob([inst, &newInstructions, &instructionMutex]() {
-            size_t startIndex(0ULL);
-            size_t max(inst->m_newData.size());
-            while (startIndex + 36ULL < max) {
-                // Find how far this value is repeated for
-                const auto& value_at_x = inst->m_newData[startIndex];
-                const auto endIndex =
-                    startIndex +
-                    find_last_in_series(
-                        value_at_x,
-                        MemoryRange{ max - startIndex,
-                                     &inst->m_newData[startIndex] });
-
-                // Quit early if repeats less than 36 bytes
-                if ((endIndex - startIndex) <= 36ULL) {
-                    startIndex = endIndex;
-                    continue;
-                }
+    InstructionList& instructions, const MemoryRange& payload,
+    std::pmr::memory_resource* resource) {
+    // Find insertions larger than 36 bytes
+    std::pmr::vector<size_t> largeInsertions(resource);
+    for (size_t x = 0ULL; x < instructions.size(); ++x)
+        if (instructions.m_opcodes[x] == Opcode::Insert &&
+            instructions.m_lengths[x] > 36ULL)
+            largeInsertions.emplace_back(x);
+
+    // Analyze them in parallel, each into its own set of new instructions,
+    // allocated from the default resource as they grow on other threads
+    std::vector<InstructionList> newInstructions(largeInsertions.size());
+    Threader::GetShared().parallel_for(
+        0ULL, largeInsertions.size(),
+        [&](const size_t& y) {
+            split_insertion(
+                instructions, largeInsertions[y], payload, newInstructions[y]);
+        },
+        1ULL);
+
+    // Join instruction sets together, in order
+    InstructionList joinedInstructions(resource);
+    size_t y(0ULL);
+    for (size_t x = 0ULL; x < instructions.size(); ++x) {
+        if (y < largeInsertions.size() && largeInsertions[y] == x) {
+            for (size_t z = 0ULL; z < newInstructions[y].size(); ++z)
+                joinedInstructions.emplace(newInstructions[y], z);
+            ++y;
+        } else
+            joinedInstructions.emplace(instructions, x);
+    }
+    instructions = std::move(joinedInstructions);
+}
+
+/** Write an unsigned LEB128 varint, returning the number of bytes written. */
+size_t write_varint(std::byte* const data, size_t value) noexcept {
+    size_t length(0ULL);
+    for (; value >= 0x80ULL; value >>= 7U)
+        data[length++] = static_cast<std::byte>((value & 0x7FULL) | 0x80ULL);
+    data[length++] = static_cast<std::byte>(value);
+    return length;
+}
+
+/** Read an unsigned LEB128 varint, advancing the byte index past it.
+@return true on success, false if truncated or overlong. */
+bool read_varint(
+    const MemoryRange& range, size_t& byteIndex, size_t& value) noexcept {
+    value = 0ULL;
+    for (size_t shift = 0ULL; shift < 64ULL; shift += 7ULL) {
+        if (byteIndex >= range.size())
+            return false;
+        const auto byte = std::to_integer<size_t>(range.bytes()[byteIndex++]);
+        value |= (byte & 0x7FULL) << shift;
+        if ((byte & 0x80ULL) == 0ULL)
+            return true;
+    }
+    return false;
+}
 
-                // Split the insertion instruction into two, plus a repeat
-                split_insertion(
-                    inst, startIndex, endIndex, value_at_x, newInstructions,
-                    instructionMutex);
+/** Map a signed delta onto an unsigned value, keeping small magnitudes small.
+*/
+size_t zigzag(const size_t& from, const size_t& to) noexcept {
+    return to >= from ? (to - from) << 1U : ((from - to) << 1U) - 1ULL;
+}
+
+/** Apply a delta mapped by zigzag. */
+size_t unzigzag(const size_t& from, const size_t& delta) noexcept {
+    return (delta & 1ULL) == 0ULL ? from + (delta >> 1U)
+                                  : from - ((delta + 1ULL) >> 1U);
+}
+
+/** Write a set of instructions out to a patch buffer, copying insertion data
+from the payload range, and the differences between it and the source range
+for additions. Positions are delta-encoded against the previous instruction as
+varints, so in-order instructions take only a few bytes. */
+Buffer encode_instructions(
+    const InstructionList& instructions, const MemoryRange& source,
+    const MemoryRange& payload, std::pmr::memory_resource* resource) {
+    // Size the buffer for the worst case, each varint taking 10 bytes
+    constexpr size_t maxVarint = 10ULL;
+    size_t patchSize(0ULL);
+    for (size_t x = 0ULL; x < instructions.size(); ++x) {
+        patchSize += sizeof(char) + (maxVarint * 3ULL) + sizeof(std::byte);
+        if (instructions.m_opcodes[x] == Opcode::Insert ||
+            instructions.m_opcodes[x] == Opcode::Add)
+            patchSize += instructions.m_lengths[x];
+    }
 
-                // Start at beginning of remaining segment
-                startIndex = 0ULL;
-                max = inst->m_newData.size();
+    // Write each instruction's opcode, followed by its attributes
+    Buffer patchBuffer(patchSize, Buffer::Init::Uninitialized, resource);
+    auto* const data = patchBuffer.bytes();
+    size_t byteIndex(0ULL);
+    size_t lastIndex(0ULL);
+    size_t lastRead(0ULL);
+    for (size_t x = 0ULL; x < instructions.size(); ++x) {
+        const auto& opcode = instructions.m_opcodes[x];
+        const auto& index = instructions.m_indices[x];
+        const auto& offset = instructions.m_offsets[x];
+        const auto& length = instructions.m_lengths[x];
+        data[byteIndex++] = static_cast<std::byte>(opcode);
+        byteIndex += write_varint(&data[byteIndex], zigzag(lastIndex, index));
+        byteIndex += write_varint(&data[byteIndex], length);
+        if (opcode == Opcode::Copy || opcode == Opcode::Add) {
+            byteIndex +=
+                write_varint(&data[byteIndex], zigzag(lastRead, offset));
+            lastRead = offset + length;
+            if (opcode == Opcode::Add) {
+                const auto* const target =
+                    &payload.bytes()[instructions.m_payloads[x]];
+                for (size_t y = 0ULL; y < length; ++y)
+                    data[byteIndex + y] = static_cast<std::byte>(
+                        std::to_integer<uint8_t>(target[y]) -
+                        std::to_integer<uint8_t>(source.bytes()[offset + y]));
+                byteIndex += length;
             }
-        });
+        } else if (opcode == Opcode::Insert) {
+            std::copy(
+                &payload.bytes()[offset], &payload.bytes()[offset + length],
+                &data[byteIndex]);
+            byteIndex += length;
+        } else
+            data[byteIndex++] = instructions.m_values[x];
+        lastIndex = index + length;
+    }
+    patchBuffer.resize(byteIndex);
+    return patchBuffer;
+}
+
+/** Read a single instruction's opcode and attributes, leaving the byte index
+at an insertion's data or an addition's differences. Positions are decoded
+relative to a cursor, which is only advanced on success.
+@return true on success, false if truncated or malformed. */
+bool read_instruction(
+    const MemoryRange& patch, size_t& byteIndex, InstructionCursor& cursor,
+    Instruction& instruction) noexcept {
+    auto position = byteIndex;
+    if (position >= patch.size())
+        return false; // Failure
+    instruction.m_opcode = static_cast<Opcode>(patch.bytes()[position++]);
+    if (!read_varint(patch, position, instruction.m_index) ||
+        !read_varint(patch, position, instruction.m_length))
+        return false; // Failure
+    instruction.m_index = unzigzag(cursor.m_lastIndex, instruction.m_index);
+    auto lastRead = cursor.m_lastRead;
+    if (instruction.m_opcode == Opcode::Copy ||
+        instruction.m_opcode == Opcode::Add) {
+        if (!read_varint(patch, position, instruction.m_offset))
+            return false; // Failure
+        instruction.m_offset = unzigzag(lastRead, instruction.m_offset);
+        instruction.m_payload = position;
+        lastRead = instruction.m_offset + instruction.m_length;
+    } else if (instruction.m_opcode == Opcode::Insert)
+        instruction.m_offset = position;
+    else if (instruction.m_opcode == Opcode::Repeat) {
+        if (position >= patch.size())
+            return false; // Failure
+        instruction.m_value = patch.bytes()[position++];
+    } else
+        return false; // Failure
+    cursor.m_lastIndex = instruction.m_index + instruction.m_length;
+    cursor.m_lastRead = lastRead;
+    byteIndex = position;
+    return true; // Success
+}
+
+/** Read a set of instructions in from a patch buffer, with insertions and
+additions referencing their data within it.
+@return the instructions on success, empty otherwise. */
+std::optional<InstructionList> decode_instructions(
+    const MemoryRange& patch, std::pmr::memory_resource* resource) {
+    InstructionList instructions(resource);
+    InstructionCursor cursor;
+    Instruction instruction;
+    size_t byteIndex(0ULL);
+    while (byteIndex < patch.size()) {
+        if (!read_instruction(patch, byteIndex, cursor, instruction))
+            return {}; // Failure
+        if (instruction.m_opcode == Opcode::Insert ||
+            instruction.m_opcode == Opcode::Add) {
+            if (patch.size() - byteIndex < instruction.m_length)
+                return {}; // Failure
+            byteIndex += instruction.m_length;
+        }
+        instructions.emplace(
+            instruction.m_opcode, instruction.m_index, instruction.m_offset,
+            instruction.m_length, instruction.m_value, instruction.m_payload);
+    }
+    return instructions;
+}
+
+/** Read a set of instructions in from a legacy patch buffer, which held
+fixed-size attributes.
+@return the instructions on success, empty otherwise. */
+std::optional<InstructionList> decode_legacy_instructions(
+    const MemoryRange& patch, std::pmr::memory_resource* resource) {
+    InstructionList instructions(resource);
+    BinaryReader reader(patch);
+    while (reader.remaining() != 0ULL) {
+        char opcode(0);
+        size_t index(0ULL);
+        size_t value(0ULL);
+        reader.read(opcode);
+        // Older patches may be padded with empty opcodes
+        if (opcode == '\0')
+            continue;
+        if (!reader.read(index, value))
+            return {}; // Failure
+        if (opcode == static_cast<char>(Opcode::Copy)) {
+            size_t endRead(0ULL);
+            if (!reader.read(endRead) || endRead < value)
+                return {}; // Failure
+            instructions.emplace(Opcode::Copy, index, value, endRead - value);
+        } else if (opcode == static_cast<char>(Opcode::Insert)) {
+            const auto payloadIndex = reader.position();
+            if (!reader.skip(value))
+                return {}; // Failure
+            instructions.emplace(Opcode::Insert, index, payloadIndex, value);
+        } else if (opcode == static_cast<char>(Opcode::Repeat)) {
+            std::byte repeatValue{ 0 };
+            if (!reader.read(repeatValue))
+                return {}; // Failure
+            instructions.emplace(
+                Opcode::Repeat, index, 0ULL, value, repeatValue);
+        } else
+            return {}; // Failure
+    }
+    return instructions;
+}
+
+/** Add byte-wise differences onto a range of data, writing the result out. */
+void add_bytes(
+    std::byte* const target, const std::byte* const source,
+    const std::byte* const differences, const size_t& length) noexcept {
+    for (size_t x = 0ULL; x < length; ++x)
+        target[x] = static_cast<std::byte>(
+            std::to_integer<uint8_t>(source[x]) +
+            std::to_integer<uint8_t>(differences[x]));
+}
+
+/** Execute part of an instruction, writing the target range between 2
+indices within it. */
+void execute_instruction(
+    const InstructionList& instructions, const size_t& x,
+    const MemoryRange& source, const MemoryRange& payload,
+    MemoryRange& target, const size_t& begin,
+    const size_t& end) noexcept {
+    const auto skip = begin - instructions.m_indices[x];
+    const auto length = end - begin;
+    switch (instructions.m_opcodes[x]) {
+    case Opcode::Copy:
+        std::memcpy(
+            &target.bytes()[begin],
+            &source.bytes()[instructions.m_offsets[x] + skip], length);
+        break;
+    case Opcode::Insert:
+        std::memcpy(
+            &target.bytes()[begin],
+            &payload.bytes()[instructions.m_offsets[x] + skip], length);
+        break;
+    case Opcode::Repeat:
+        std::memset(
+            &target.bytes()[begin],
+            std::to_integer<int>(instructions.m_values[x]), length);
+        break;
+    case Opcode::Add:
+        add_bytes(
+            &target.bytes()[begin],
+            &source.bytes()[instructions.m_offsets[x] + skip],
+            &payload.bytes()[instructions.m_payloads[x] + skip], length);
+        break;
+    }
+}
+
+/** Execute a set of instructions, writing the target range. Instructions
+writing disjoint regions are executed in parallel, by splitting the target into
+stripes, otherwise they are executed serially in order. Any bytes left unwritten
+are zeroed.
+@return true on success, false if any instruction falls out of range. */
+bool apply_instructions(
+    const InstructionList& instructions, const MemoryRange& source,
+    const MemoryRange& payload, MemoryRange& target) {
+    // Ensure every instruction stays in range
+    for (size_t x = 0ULL; x < instructions.size(); ++x) {
+        const auto& index = instructions.m_indices[x];
+        const auto& offset = instructions.m_offsets[x];
+        const auto& length = instructions.m_lengths[x];
+        if (index > target.size() || length > target.size() - index ||
+            ((instructions.m_opcodes[x] == Opcode::Copy ||
+              instructions.m_opcodes[x] == Opcode::Add) &&
+             (offset > source.size() || length > source.size() - offset)))
+            return false; // Failure
+    }
+
+    // Order the instructions by where they write to
+    std::pmr::vector<size_t> order(
+        instructions.size(), instructions.m_indices.get_allocator());
+    std::iota(order.begin(), order.end(), 0ULL);
+    const auto byIndex = [&](const size_t& a, const size_t& b) noexcept {
+        return instructions.m_indices[a] < instructions.m_indices[b];
+    };
+    if (!std::is_sorted(order.cbegin(), order.cend(), byIndex))
+        std::stable_sort(order.begin(), order.end(), byIndex);
+
+    // Overlapping instructions depend on their order, so execute them serially
+    for (size_t y = 1ULL; y < order.size(); ++y) {
+        const auto& previous = order[y - 1ULL];
+        const auto previousEnd =
+            instructions.m_indices[previous] + instructions.m_lengths[previous];
+        if (previousEnd > instructions.m_indices[order[y]]) {
+            std::memset(target.bytes(), 0, target.size());
+            for (size_t x = 0ULL; x < instructions.size(); ++x)
+                execute_instruction(
+                    instructions, x, source, payload, target,
+                    instructions.m_indices[x],
+                    instructions.m_indices[x] + instructions.m_lengths[x]);
+            return true; // Success
+        }
+    }
+
+    // Execute each stripe of the target in parallel, clipping any instructions
+    // that cross into it, and zeroing any gaps between them
+    const auto stripeCount =
+        (target.size() + PatchStripeSize - 1ULL) / PatchStripeSize;
+    Threader::GetShared().parallel_for(
+        0ULL, stripeCount,
+        [&](const size_t& stripe) {
+            const auto stripeBegin = stripe * PatchStripeSize;
+            const auto stripeEnd =
+                std::min(stripeBegin + PatchStripeSize, target.size());
+
+            // Find the first instruction ending within this stripe
+            auto y = static_cast<size_t>(std::distance(
+                order.cbegin(),
+                std::partition_point(
+                    order.cbegin(), order.cend(), [&](const size_t& x) {
+                        return instructions.m_indices[x] +
+                                   instructions.m_lengths[x] <=
+                               stripeBegin;
+                    })));
+            auto written = stripeBegin;
+            for (; y < order.size(); ++y) {
+                const auto& x = order[y];
+                const auto& index = instructions.m_indices[x];
+                if (index >= stripeEnd)
+                    break;
+                const auto begin = std::max(index, stripeBegin);
+                const auto end =
+                    std::min(index + instructions.m_lengths[x], stripeEnd);
+                std::memset(&target.bytes()[written], 0, begin - written);
+                execute_instruction(
+                    instructions, x, source, payload, target, begin, end);
+                written = end;
+            }
+            std::memset(&target.bytes()[written], 0, stripeEnd - written);
+        },
+        1ULL);
+    return true; // Success
+}
+
+/** Read in the header and block offsets of a block compressed range,
+ensuring its layout is consistent, and that every block's compressed data could
+fill it, before anything is allocated for its uncompressed size.
+@return true on success, false otherwise. */
+bool read_block_layout(
+    const MemoryRange& memoryRange, BlockCompressionHeader& header,
+    std::pmr::vector<size_t>& blockEnds) {
+    // Ensure header title matches, and its block layout is consistent
+    if (memoryRange.size() < sizeof(BlockCompressionHeader))
+        return false; // Failure
+    memoryRange.out_type(header);
+    if (std::strcmp(header.m_title, "yatta blocks") != 0 ||
+        header.m_blockSize != CompressionBlockSize ||
+        header.m_blockCount !=
+            header.m_uncompressedSize / header.m_blockSize +
+                (header.m_uncompressedSize % header.m_blockSize != 0ULL) ||
+        header.m_blockCount >
+            (memoryRange.size() - sizeof(BlockCompressionHeader)) /
+                sizeof(size_t))
+        return false; // Failure
+
+    // Read in the block offsets, ensuring they stay in order and in range
+    const auto headerSize =
+        sizeof(BlockCompressionHeader) + (sizeof(size_t) * header.m_blockCount);
+    blockEnds.resize(header.m_blockCount);
+    memoryRange.out_raw(
+        blockEnds.data(), sizeof(size_t) * header.m_blockCount,
+        sizeof(BlockCompressionHeader));
+    size_t previousEnd(0ULL);
+    for (size_t block = 0ULL; block < header.m_blockCount; ++block) {
+        const auto& blockEnd = blockEnds[block];
+        const auto blockSize = std::min(
+            header.m_blockSize,
+            header.m_uncompressedSize - (block * header.m_blockSize));
+        if (blockEnd < previousEnd ||
+            blockEnd > memoryRange.size() - headerSize ||
+            blockSize > (blockEnd - previousEnd) * LZ4MaxRatio)
+            return false; // Failure
+        previousEnd = blockEnd;
+    }
+    return true; // Success
+}
+
+/** Decompress a single block of a block compressed range.
+@return the block's decompressed size on success, 0 otherwise. */
+size_t decompress_block(
+    const MemoryRange& memoryRange, const BlockCompressionHeader& header,
+    const std::pmr::vector<size_t>& blockEnds, const size_t& block,
+    char* const destination) noexcept {
+    const auto headerSize =
+        sizeof(BlockCompressionHeader) + (sizeof(size_t) * header.m_blockCount);
+    const auto blockBegin = block == 0ULL ? 0ULL : blockEnds[block - 1ULL];
+    const auto size = std::min(
+        header.m_blockSize,
+        header.m_uncompressedSize - (block * header.m_blockSize));
+    const auto decompressionResult = LZ4_decompress_safe(
+        &memoryRange.charArray()[headerSize + blockBegin], destination,
+        static_cast<int>(blockEnds[block] - blockBegin),
+        static_cast<int>(size));
+
+    // Ensure the block filled its entire range
+    return decompressionResult == static_cast<int>(size) ? size : 0ULL;
+}
+
+/** Decompress a memory range written in the legacy single block format. */
+std::optional<Buffer> decompress_legacy(
+    const MemoryRange& memoryRange, const CompressionHeader& header,
+    std::pmr::memory_resource* resource) {
+    // Ensure the sizes fit within a single LZ4 call
+    constexpr auto headerSize = sizeof(CompressionHeader);
+    if (header.m_uncompressedSize > static_cast<size_t>(INT_MAX) ||
+        memoryRange.size() - headerSize > static_cast<size_t>(INT_MAX))
+        return {}; // Failure
+
+    // Uncompress the remaining data
+    Buffer uncompressedBuffer(
+        header.m_uncompressedSize, Buffer::Init::Uninitialized, resource);
+    const auto decompressionResult = LZ4_decompress_safe(
+        &memoryRange.charArray()[headerSize], uncompressedBuffer.charArray(),
+        static_cast<int>(memoryRange.size() - headerSize),
+        static_cast<int>(uncompressedBuffer.size()));
+
+    // Ensure the entire buffer was decompressed
+    if (decompressionResult != static_cast<int>(uncompressedBuffer.size()))
+        return {}; // Failure
+
+    // Success
+    return uncompressedBuffer;
+}
+
+/** Read 4 bytes from a pointer. */
+uint32_t read_u32(const std::byte* const data) noexcept {
+    uint32_t value(0U);
+    std::memcpy(&value, data, sizeof(uint32_t));
+    return value;
+}
+
+/** Hash the 4 bytes at a pointer into the high compression hash table. */
+size_t hash_u32(const std::byte* const data) noexcept {
+    return static_cast<size_t>(
+        (read_u32(data) * 2654435761U) >> (32U - HCHashBits));
+}
+
+/** Write an LZ4 length continuation, returning false if out of room. */
+bool write_length(
+    char*& output, const char* const outputEnd, size_t length) noexcept {
+    for (; length >= 255ULL; length -= 255ULL) {
+        if (output >= outputEnd)
+            return false;
+        *output++ = static_cast<char>(255U);
     }
+    if (output >= outputEnd)
+        return false;
+    *output++ = static_cast<char>(length);
+    return true;
+}
+
+/** Write an LZ4 sequence of literals followed by an optional match, returning
+false if out of room. */
+bool write_sequence(
+    char*& output, const char* const outputEnd,
+    const std::byte* const literals, const size_t& literalLength,
+    const size_t& offset, const size_t& matchLength) noexcept {
+    // Write the token, holding the start of both lengths
+    if (output >= outputEnd)
+        return false;
+    const auto matchCode = matchLength == 0ULL ? 0ULL : matchLength - 4ULL;
+    *output++ = static_cast<char>(
+        (std::min<size_t>(literalLength, 15ULL) << 4U) |
+        std::min<size_t>(matchCode, 15ULL));
+    if (literalLength >= 15ULL &&
+        !write_length(output, outputEnd, literalLength - 15ULL))
+        return false;
+
+    // Write the literals
+    if (static_cast<size_t>(outputEnd - output) < literalLength)
+        return false;
+    std::memcpy(output, literals, literalLength);
+    output += literalLength;
+
+    // The final sequence holds no match
+    if (matchLength == 0ULL)
+        return true;
+    if (outputEnd - output < 2)
+        return false;
+    *output++ = static_cast<char>(offset & 0xFFU);
+    *output++ = static_cast<char>(offset >> 8U);
+    return matchCode < 15ULL ||
+           write_length(output, outputEnd, matchCode - 15ULL);
+}
+
+/** Compress a block into the LZ4 block format using a hash chain match
+finder, searching deeper for higher levels.
+@return the compressed size on success, 0 otherwise. */
+size_t compress_block_hc(
+    const std::byte* const source, const size_t& sourceSize,
+    char* const destination, const size_t& destinationSize,
+    const int& level) {
+    char* output = destination;
+    const char* const outputEnd = destination + destinationSize;
+    const auto maxAttempts = 1ULL << static_cast<size_t>(level - 1);
+
+    // Chain together every position sharing a hash, within the match window
+    constexpr auto NoPosition = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> head(1ULL << HCHashBits, NoPosition);
+    std::vector<uint32_t> chain(LZ4MaxOffset + 1ULL, NoPosition);
+    size_t nextInsert(0ULL);
+    const auto findMatch = [&](const size_t& position,
+                               const size_t& maxLength) noexcept {
+        for (; nextInsert <= position; ++nextInsert) {
+            auto& bucket = head[hash_u32(&source[nextInsert])];
+            chain[nextInsert & LZ4MaxOffset] = bucket;
+            bucket = static_cast<uint32_t>(nextInsert);
+        }
+
+        // Keep the longest match, preferring the nearest
+        MatchInfo best;
+        auto candidate = chain[position & LZ4MaxOffset];
+        for (size_t attempt = 0ULL; attempt < maxAttempts &&
+                                    candidate != NoPosition &&
+                                    position - candidate <= LZ4MaxOffset;
+             ++attempt) {
+            if (read_u32(&source[candidate]) == read_u32(&source[position])) {
+                const auto length =
+                    4ULL + count_matching(
+                               &source[candidate + 4ULL],
+                               &source[position + 4ULL], maxLength - 4ULL);
+                if (length > best.length)
+                    best = MatchInfo{ length, candidate, position };
+            }
+            candidate = chain[candidate & LZ4MaxOffset];
+        }
+        return best;
+    };
+
+    // Greedily take matches, unless the next position holds a longer one
+    size_t anchor(0ULL);
+    if (sourceSize > LZ4MatchLimit) {
+        const auto matchStartLimit = sourceSize - LZ4MatchLimit;
+        const auto matchEndLimit = sourceSize - LZ4LastLiterals;
+        size_t position(0ULL);
+        while (position < matchStartLimit) {
+            auto match = findMatch(position, matchEndLimit - position);
+            if (match.length < 4ULL) {
+                ++position;
+                continue;
+            }
+            while (position + 1ULL < matchStartLimit) {
+                const auto next =
+                    findMatch(position + 1ULL, matchEndLimit - position - 1ULL);
+                if (next.length <= match.length)
+                    break;
+                match = next;
+                ++position;
+            }
 
-    // Wait for jobs to finish
-    while (!threader.isFinished())
-        continue;
-    threader.shutdown();
+            if (!write_sequence(
+                    output, outputEnd, &source[anchor], position - anchor,
+                    position - match.start1, match.length))
+                return 0ULL; // Failure
+            position += match.length;
+            anchor = position;
+        }
+    }
 
-    // Join instruction sets together
-    baseInstructions.reserve(baseInstructions.size() + newInstructions.size());
-    baseInstructions.insert(
-        baseInstructions.end(),
-        std::make_move_iterator(newInstructions.begin()),
-        std::make_move_iterator(newInstructions.end()));
+    // Finish with the remaining literals
+    if (!write_sequence(
+            output, outputEnd, &source[anchor], sourceSize - anchor, 0ULL,
+            0ULL))
+        return 0ULL; // Failure
+    return static_cast<size_t>(output - destination);
+}
+
+/** Sends a target range to a sink in order, a stripe at a time, so that it
+never has to be held in memory whole. */
+class PatchWriter {
+    public:
+    // Public (de)constructors
+    PatchWriter(const size_t& targetSize, const yatta::StreamSink& sink)
+        : m_targetSize(targetSize), m_sink(sink),
+          m_buffer(PatchStripeSize, Buffer::Init::Uninitialized) {}
+
+    // Public Methods
+    /** Skip ahead to an index, zero-filling the gap. */
+    bool seek(const size_t& index) {
+        if (index < m_position)
+            return false; // Failure
+        return fill(std::byte{ 0 }, index - m_position);
+    }
+    /** Write a range of data. */
+    bool write(const MemoryRange& range) {
+        if (range.size() > m_targetSize - m_position)
+            return false; // Failure
+
+        // Send large ranges straight to the sink
+        if (m_fill == 0ULL && range.size() >= m_buffer.size()) {
+            m_position += range.size();
+            return m_sink(range);
+        }
+        for (size_t index = 0ULL; index < range.size();) {
+            const auto amount =
+                std::min(m_buffer.size() - m_fill, range.size() - index);
+            m_buffer.in_raw(&range.bytes()[index], amount, m_fill);
+            if (!advance(amount))
+                return false; // Failure
+            index += amount;
+        }
+        return true; // Success
+    }
+    /** Write a range of data with byte-wise differences added onto it. */
+    bool add(const MemoryRange& range, const MemoryRange& differences) {
+        if (range.size() > m_targetSize - m_position)
+            return false; // Failure
+        for (size_t index = 0ULL; index < range.size();) {
+            const auto amount =
+                std::min(m_buffer.size() - m_fill, range.size() - index);
+            add_bytes(
+                &m_buffer[m_fill], &range.bytes()[index],
+                &differences.bytes()[index], amount);
+            if (!advance(amount))
+                return false; // Failure
+            index += amount;
+        }
+        return true; // Success
+    }
+    /** Write a repeating value. */
+    bool fill(const std::byte& value, size_t length) {
+        if (length > m_targetSize - m_position)
+            return false; // Failure
+        while (length > 0ULL) {
+            const auto amount = std::min(m_buffer.size() - m_fill, length);
+            std::fill(&m_buffer[m_fill], &m_buffer[m_fill] + amount, value);
+            if (!advance(amount))
+                return false; // Failure
+            length -= amount;
+        }
+        return true; // Success
+    }
+    /** Zero-fill the remainder of the target, sending anything left over. */
+    bool finish() {
+        return seek(m_targetSize) &&
+               (m_fill == 0ULL || m_sink(m_buffer.subrange(0ULL, m_fill)));
+    }
+
+    private:
+    // Private Methods
+    /** Account for newly buffered data, sending the buffer once full. */
+    bool advance(const size_t& amount) {
+        m_fill += amount;
+        m_position += amount;
+        if (m_fill < m_buffer.size())
+            return true; // Success
+        m_fill = 0ULL;
+        return m_sink(m_buffer);
+    }
+
+    // Private Attributes
+    size_t m_targetSize = 0ULL, m_position = 0ULL, m_fill = 0ULL;
+    const yatta::StreamSink& m_sink;
+    Buffer m_buffer;
+};
+
+/** Read in the header of a patch, mapping legacy headers to version 1.
+@return the header on success, empty otherwise. */
+std::optional<DifferentialHeader> read_diff_header(const MemoryRange& diff) {
+    // Read in header, falling back to the legacy format
+    if (diff.size() < sizeof(LegacyDifferentialHeader))
+        return {}; // Failure
+    LegacyDifferentialHeader legacyHeader;
+    diff.out_type(legacyHeader);
+    if (std::strcmp(legacyHeader.m_title, "yatta diff") == 0)
+        return DifferentialHeader{ "yatta diff", 1ULL,
+                                   legacyHeader.m_targetSize };
+
+    // Ensure header title and version match
+    DifferentialHeader header;
+    if (diff.size() < sizeof(DifferentialHeader))
+        return {}; // Failure
+    diff.out_type(header);
+    if (std::strcmp(header.m_title, "yatta patch") != 0 ||
+        header.m_version != DiffVersion)
+        return {}; // Failure
+    return header;
 }
 
 // Public (de)Constructors
 
 Buffer::Buffer(const size_t& size)
     : MemoryRange(size, nullptr), m_capacity(size * 2ULL),
-      m_data(std::make_unique<std::byte[]>(m_capacity)) {
+      m_data(allocate(m_capacity)) {
+    m_dataPtr = m_data.get();
+    std::fill(m_dataPtr, m_dataPtr + m_range, std::byte{ 0 });
+}
+
+Buffer::Buffer(std::pmr::memory_resource* const resource) noexcept
+    : m_resource(resource) {}
+
+Buffer::Buffer(
+    const size_t& size, const Init& init,
+    std::pmr::memory_resource* const resource)
+    : MemoryRange(size, nullptr), m_capacity(size), m_resource(resource),
+      m_data(allocate(m_capacity)) {
     m_dataPtr = m_data.get();
+    if (init == Init::Zeroed)
+        std::fill(m_dataPtr, m_dataPtr + m_range, std::byte{ 0 });
 }
 
 Buffer::Buffer(const Buffer& other)
     : MemoryRange(other), m_capacity(other.m_capacity),
-      m_data(std::make_unique<std::byte[]>(other.m_capacity)) {
+      m_data(allocate(other.m_capacity)) {
     m_dataPtr = m_data.get();
     std::copy(
         other.m_data.get(), other.m_data.get() + other.m_range, m_data.get());
@@ -496,7 +1297,7 @@ Buffer::Buffer(const Buffer& other)
 
 Buffer::Buffer(Buffer&& other) noexcept
     : MemoryRange(std::move(other)), m_capacity(other.m_capacity),
-      m_data(std::move(other.m_data)) {
+      m_resource(other.m_resource), m_data(std::move(other.m_data)) {
     other.m_capacity = 0ULL;
     other.m_data = nullptr;
 }
@@ -507,7 +1308,7 @@ Buffer& Buffer::operator=(const Buffer& other) {
     if (this != &other) {
         m_range = other.m_range;
         m_capacity = other.m_capacity;
-        m_data = std::make_unique<std::byte[]>(other.m_capacity);
+        m_data = allocate(other.m_capacity);
         m_dataPtr = m_data.get();
         std::copy(
             other.m_data.get(), other.m_data.get() + other.m_range,
@@ -520,6 +1321,7 @@ Buffer& Buffer::operator=(Buffer&& other) noexcept {
     if (this != &other) {
         m_range = other.m_range;
         m_capacity = other.m_capacity;
+        m_resource = other.m_resource;
         m_data = std::move(other.m_data);
         m_dataPtr = m_data.get();
 
@@ -539,37 +1341,23 @@ bool Buffer::empty() const noexcept {
 
 size_t Buffer::capacity() const noexcept { return m_capacity; }
 
+std::pmr::memory_resource* Buffer::resource() const noexcept {
+    return m_resource;
+}
+
 // Public Manipulation Methods
 
 void Buffer::resize(const size_t& size) {
-    // Create the data container if it is missing
-    if (m_data == nullptr) {
-        m_capacity = size * 2ULL;
-        m_data = std::make_unique<std::byte[]>(m_capacity);
-        m_dataPtr = m_data.get();
-    }
-
-    // Check if our previous buffer is too small
-    else if (size > m_capacity) {
-        // Allocate new container
-        m_capacity = size * 2ULL;
-        auto newData = std::make_unique<std::byte[]>(m_capacity);
-
-        // Copy over old data
-        std::copy(m_data.get(), m_data.get() + m_range, newData.get());
-
-        // Swap data containers
-        m_data.swap(newData);
-        m_dataPtr = m_data.get();
-    }
-
-    m_range = size;
+    const auto oldSize = m_range;
+    expand(size);
+    if (size > oldSize)
+        std::fill(m_dataPtr + oldSize, m_dataPtr + size, std::byte{ 0 });
 }
 
 void Buffer::reserve(const size_t& capacity) {
     if (capacity > m_capacity) {
         m_capacity = capacity;
-        auto newData = std::make_unique<std::byte[]>(m_capacity);
+        auto newData = allocate(m_capacity);
 
         // Copy previous data if present
         if (m_data != nullptr)
@@ -587,7 +1375,7 @@ void Buffer::shrink() {
         return;
 
     // Allocate new container
-    auto newData = std::make_unique<std::byte[]>(m_range);
+    auto newData = allocate(m_range);
 
     // Copy over old data
     std::copy(m_data.get(), m_data.get() + m_range, newData.get());
@@ -612,7 +1400,7 @@ void Buffer::push_raw(const void* const dataPtr, const size_t& size) {
     // Find the starting index to write at
     const auto byteIndex = m_range;
     // Grow the container to hold the new data
-    resize(m_range + size);
+    expand(m_range + size);
     // Copy the data into the container
     in_raw(dataPtr, size, byteIndex);
 }
@@ -628,43 +1416,85 @@ void Buffer::pop_raw(void* const dataPtr, const size_t& size) {
 
 // Public Derivation Methods
 
-std::optional<Buffer> Buffer::compress() const {
-    return Buffer::compress(*this);
+std::optional<Buffer> Buffer::compress(const int& level) const {
+    return Buffer::compress(*this, level);
 }
 
-std::optional<Buffer> Buffer::compress(const Buffer& buffer) {
+std::optional<Buffer>
+Buffer::compress(const Buffer& buffer, const int& level) {
     const MemoryRange& range = buffer;
-    return Buffer::compress(range);
+    return Buffer::compress(range, level);
 }
 
-std::optional<Buffer> Buffer::compress(const MemoryRange& memoryRange) {
+std::optional<Buffer> Buffer::compress(
+    const MemoryRange& memoryRange, const int& level,
+    std::pmr::memory_resource* const resource, const size_t& headroom) {
     // Ensure this buffer has some data to compress
     if (memoryRange.empty())
         return {}; // Failure
 
-    // Create a larger buffer twice the size, plus a unique header
+    // Create a buffer large enough for every block's worst case, plus a unique
+    // header and the block offsets, after any headroom
     const auto sourceSize = memoryRange.size();
-    const auto destinationSize = sourceSize * 2ULL;
-    constexpr auto headerSize = sizeof(CompressionHeader);
-    Buffer compressedBuffer(headerSize + destinationSize);
-    CompressionHeader compressionHeader{ "yatta compress", sourceSize };
-
-    // Copy header data into new buffer at the beginning
-    compressedBuffer.in_type(compressionHeader);
-
-    // Try to compress the source buffer
-    const auto compressedSize = LZ4_compress_default(
-        memoryRange.charArray(),
-        &compressedBuffer.charArray()[headerSize], // Offset by header's amount
-        static_cast<int>(sourceSize), static_cast<int>(destinationSize));
-
-    // Ensure we have a non-zero sized buffer
-    if (compressedSize == 0ULL)
+    const auto blockCount =
+        (sourceSize + CompressionBlockSize - 1ULL) / CompressionBlockSize;
+    const auto blockBound = static_cast<size_t>(
+        LZ4_compressBound(static_cast<int>(CompressionBlockSize)));
+    const auto headerSize = headroom + sizeof(BlockCompressionHeader) +
+                            (sizeof(size_t) * blockCount);
+    Buffer compressedBuffer(
+        headerSize + (blockBound * blockCount), Buffer::Init::Uninitialized,
+        resource);
+    BlockCompressionHeader compressionHeader{ "yatta blocks", sourceSize,
+                                              CompressionBlockSize,
+                                              blockCount };
+
+    // Copy header data into new buffer, past the headroom
+    compressedBuffer.in_type(compressionHeader, headroom);
+
+    // Try to compress every block in parallel, each into its own slot
+    std::pmr::vector<size_t> blockSizes(blockCount, 0ULL, resource);
+    Threader::GetShared().parallel_for(
+        0ULL, blockCount,
+        [&](const size_t& block) {
+            const auto begin = block * CompressionBlockSize;
+            const auto size =
+                std::min(CompressionBlockSize, sourceSize - begin);
+            const auto destination = headerSize + (block * blockBound);
+            if (level <= yatta::FastCompression)
+                blockSizes[block] = static_cast<size_t>(LZ4_compress_default(
+                    &memoryRange.charArray()[begin],
+                    &compressedBuffer.charArray()[destination],
+                    static_cast<int>(size), static_cast<int>(blockBound)));
+            else
+                blockSizes[block] = compress_block_hc(
+                    &memoryRange.bytes()[begin],
+                    size, &compressedBuffer.charArray()[destination],
+                    blockBound, std::min(level, yatta::MaxCompression));
+        },
+        1ULL);
+
+    // Ensure every block compressed to a non-zero size
+    if (std::find(blockSizes.cbegin(), blockSizes.cend(), 0ULL) !=
+        blockSizes.cend())
         return {}; // Failure
 
+    // Pack the blocks together, recording where each one ends
+    size_t blockEnd(0ULL);
+    for (size_t block = 0ULL; block < blockCount; ++block) {
+        std::memmove(
+            &compressedBuffer.charArray()[headerSize + blockEnd],
+            &compressedBuffer.charArray()[headerSize + (block * blockBound)],
+            blockSizes[block]);
+        blockEnd += blockSizes[block];
+        compressedBuffer.in_type(
+            blockEnd, headroom + sizeof(BlockCompressionHeader) +
+                          (sizeof(size_t) * block));
+    }
+
     // We now know the actual compressed size, downsize our oversized buffer to
     // the compressed size
-    compressedBuffer.resize(headerSize + compressedSize);
+    compressedBuffer.resize(headerSize + blockEnd);
     compressedBuffer.shrink();
 
     // Success
@@ -680,89 +1510,87 @@ std::optional<Buffer> Buffer::decompress(const Buffer& buffer) {
     return Buffer::decompress(range);
 }
 
-std::optional<Buffer> Buffer::decompress(const MemoryRange& memoryRange) {
+std::optional<Buffer> Buffer::decompress(
+    const MemoryRange& memoryRange, std::pmr::memory_resource* const resource) {
     // Ensure this buffer has some data to decompress
-    constexpr auto headerSize = sizeof(CompressionHeader);
-    if (memoryRange.size() < headerSize)
+    if (memoryRange.size() < sizeof(CompressionHeader))
         return {}; // Failure
 
-    // Read in header
-    CompressionHeader header;
-    memoryRange.out_type(header);
-
-    // Ensure header title matches
-    if (std::strcmp(header.m_title, "yatta compress") != 0)
+    // Read in header, falling back to the legacy single block format
+    CompressionHeader legacyHeader;
+    memoryRange.out_type(legacyHeader);
+    if (std::strcmp(legacyHeader.m_title, "yatta compress") == 0)
+        return decompress_legacy(memoryRange, legacyHeader, resource);
+    BlockCompressionHeader header;
+    std::pmr::vector<size_t> blockEnds(resource);
+    if (!read_block_layout(memoryRange, header, blockEnds))
         return {}; // Failure
 
-    // Uncompress the remaining data
-    Buffer uncompressedBuffer(header.m_uncompressedSize);
-    const auto decompressionResult = LZ4_decompress_safe(
-        &memoryRange.charArray()[headerSize], uncompressedBuffer.charArray(),
-        static_cast<int>(memoryRange.size() - headerSize),
-        static_cast<int>(uncompressedBuffer.size()));
-
-    // Ensure we have a non-zero sized decompressed buffer
-    if (decompressionResult <= 0)
+    // Uncompress every block in parallel
+    Buffer uncompressedBuffer(
+        header.m_uncompressedSize, Buffer::Init::Uninitialized, resource);
+    std::atomic_bool success(true);
+    Threader::GetShared().parallel_for(
+        0ULL, header.m_blockCount,
+        [&](const size_t& block) {
+            if (decompress_block(
+                    memoryRange, header, blockEnds, block,
+                    &uncompressedBuffer
+                         .charArray()[block * header.m_blockSize]) == 0ULL)
+                success = false;
+        },
+        1ULL);
+    if (!success)
         return {}; // Failure
 
     // Success
     return uncompressedBuffer;
 }
 
-std::optional<Buffer> Buffer::diff(const Buffer& target) const {
-    return Buffer::diff(*this, target);
+std::optional<Buffer>
+Buffer::diff(const Buffer& target, const DiffOptions& options) const {
+    return Buffer::diff(*this, target, options);
 }
 
-std::optional<Buffer>
-Buffer::diff(const Buffer& sourceBuffer, const Buffer& targetBuffer) {
+std::optional<Buffer> Buffer::diff(
+    const Buffer& sourceBuffer, const Buffer& targetBuffer,
+    const DiffOptions& options) {
     const MemoryRange& sourcetRange = sourceBuffer;
     const MemoryRange& targetRange = targetBuffer;
-    return Buffer::diff(sourcetRange, targetRange);
+    return Buffer::diff(sourcetRange, targetRange, options);
 }
 
-std::optional<Buffer>
-Buffer::diff(const MemoryRange& sourceMemory, const MemoryRange& targetMemory) {
+std::optional<Buffer> Buffer::diff(
+    const MemoryRange& sourceMemory, const MemoryRange& targetMemory,
+    const DiffOptions& options) {
     // Ensure that at least ONE of the two source buffers exists
     if (sourceMemory.empty() && targetMemory.empty())
         return {}; // Failure
 
     // Convert matching regions into diff instructions
-    auto instructions = generate_instructions(sourceMemory, targetMemory);
+    auto instructions =
+        generate_instructions(sourceMemory, targetMemory, options);
 
     // Replace insertions with some repeat instructions
-    insertions_to_repeats(instructions);
-
-    // Create a buffer to contain all the diff instructions
-    const auto size_patch = std::accumulate(
-        instructions.cbegin(), instructions.cend(), 0ULL,
-        [](const auto& currentSum, const auto& instruction) noexcept {
-            return currentSum + instruction->size();
-        });
-    Buffer patchBuffer(size_patch);
+    insertions_to_repeats(instructions, targetMemory, options.m_resource);
 
     // Write the instruction data to a buffer
-    for (const auto& instruction : instructions)
-        instruction->write(patchBuffer);
-
-    // Free up memory
-    instructions.clear();
-    instructions.shrink_to_fit();
-
-    // Try to compress the patch buffer
-    if (auto result = patchBuffer.compress())
-        std::swap(patchBuffer, *result);
-    else
+    auto patchBuffer =
+        encode_instructions(
+            instructions, sourceMemory, targetMemory, options.m_resource);
+    instructions = InstructionList(options.m_resource);
+
+    // Try to compress the patch buffer, leaving room for the header
+    auto bufferWithHeader = compress(
+        patchBuffer, options.m_compressionLevel, options.m_resource,
+        sizeof(DifferentialHeader));
+    if (!bufferWithHeader.has_value())
         return {}; // Failure
 
-    // Prepend header information
-    constexpr size_t headerSize = sizeof(DifferentialHeader);
-    DifferentialHeader diffHeader{ "yatta diff", targetMemory.size() };
-    Buffer bufferWithHeader;
-    bufferWithHeader.reserve(patchBuffer.size() + headerSize);
-
-    // Copy header data into new buffer at the beginning
-    bufferWithHeader.push_type(diffHeader);
-    bufferWithHeader.push_raw(patchBuffer.bytes(), patchBuffer.size());
+    // Write header data into the room left at the beginning
+    const DifferentialHeader diffHeader{ "yatta patch", DiffVersion,
+                                         targetMemory.size() };
+    bufferWithHeader->in_type(diffHeader);
 
     return bufferWithHeader; // Success
 }
@@ -778,54 +1606,191 @@ Buffer::patch(const Buffer& sourceBuffer, const Buffer& diffBuffer) {
     return Buffer::patch(sourcetRange, diffRange);
 }
 
-std::optional<Buffer>
-Buffer::patch(const MemoryRange& sourceMemory, const MemoryRange& diffMemory) {
+std::optional<Buffer> Buffer::patch(
+    const MemoryRange& sourceMemory, const MemoryRange& diffMemory,
+    std::pmr::memory_resource* const resource) {
     // Ensure diff buffer at least *exists*, empty source = new file
     if (diffMemory.empty())
         return {}; // Failure
 
     // Read in header
-    DifferentialHeader header;
-    diffMemory.out_type(header);
-
-    // Ensure header title matches
-    if (std::strcmp(header.m_title, "yatta diff") != 0)
+    const auto header = read_diff_header(diffMemory);
+    if (!header.has_value())
         return {}; // Failure
+    const auto isLegacy = header->m_version == 1ULL;
+    const auto headerSize = isLegacy ? sizeof(LegacyDifferentialHeader)
+                                     : sizeof(DifferentialHeader);
 
     // Try to decompress the diff buffer
-    constexpr size_t diffHeaderSize = sizeof(DifferentialHeader);
-    const auto dataSize = diffMemory.size() - diffHeaderSize;
+    const auto dataSize = diffMemory.size() - headerSize;
     auto patchBuffer =
-        decompress(diffMemory.subrange(diffHeaderSize, dataSize));
+        decompress(diffMemory.subrange(headerSize, dataSize), resource);
     if (!patchBuffer.has_value())
         return {}; // Failure
-    const auto patchBufferSize = patchBuffer->size();
 
-    // Convert buffer into instructions
-    Buffer bufferNew(header.m_targetSize);
-    size_t byteIndex(0ULL);
-    while (byteIndex < patchBufferSize) {
-        // Deduce the instruction type
-        char type(0);
-        patchBuffer->out_type(type, byteIndex);
-        byteIndex += sizeof(char);
-
-        // Make and execute the instruction from the diff buffer memory
-        const auto executeInstruction = [&](auto instruction) {
-            // Read the instruction
-            instruction.read(*patchBuffer, byteIndex);
-
-            // Execute the instruction
-            instruction.execute(bufferNew, sourceMemory);
-        };
-        if (type == 'R')
-            executeInstruction(Repeat_Instruction());
-        else if (type == 'I')
-            executeInstruction(Insert_Instruction());
-        else if (type == 'C')
-            executeInstruction(Copy_Instruction());
-    }
+    // Convert buffer into instructions, then execute them
+    const auto instructions =
+        isLegacy ? decode_legacy_instructions(*patchBuffer, resource)
+                 : decode_instructions(*patchBuffer, resource);
+    Buffer bufferNew(
+        header->m_targetSize, Buffer::Init::Uninitialized, resource);
+    if (!instructions.has_value() ||
+        !apply_instructions(
+            *instructions, sourceMemory, *patchBuffer, bufferNew))
+        return {}; // Failure
 
     // Success
     return bufferNew;
-}
\ No newline at end of file
+}
+
+bool Buffer::patch(
+    const MemoryRange& sourceMemory, const MemoryRange& diffMemory,
+    const StreamSink& sink) {
+    // Ensure diff buffer at least *exists*, empty source = new file
+    if (diffMemory.empty())
+        return false; // Failure
+
+    // Read in header
+    const auto header = read_diff_header(diffMemory);
+    if (!header.has_value())
+        return false; // Failure
+    PatchWriter writer(header->m_targetSize, sink);
+
+    // Legacy patches may be out of order, so patch them in memory, as with
+    // any patch whose instructions aren't block compressed
+    const auto patch_in_memory = [&]() {
+        const auto result = patch(sourceMemory, diffMemory);
+        return result.has_value() && writer.write(*result) && writer.finish();
+    };
+    if (header->m_version == 1ULL)
+        return patch_in_memory();
+    const auto diffData = diffMemory.subrange(
+        sizeof(DifferentialHeader),
+        diffMemory.size() - sizeof(DifferentialHeader));
+    BlockCompressionHeader blockHeader;
+    std::pmr::vector<size_t> blockEnds;
+    if (!read_block_layout(diffData, blockHeader, blockEnds))
+        return patch_in_memory();
+
+    // Decompress one block at a time, after any partial instruction left over
+    // from the previous block, the layout bounding blocks to the format's size
+    constexpr size_t maxInstructionSize = 32ULL;
+    Buffer window(
+        maxInstructionSize + blockHeader.m_blockSize,
+        Buffer::Init::Uninitialized);
+    InstructionCursor cursor;
+    Instruction instruction;
+    size_t carried(0ULL);
+    size_t pendingPayload(0ULL);
+    size_t pendingRead(0ULL);
+    auto pendingOpcode = Opcode::Insert;
+    const auto write_payload = [&](const MemoryRange& payload) {
+        // Write the data of the pending insertion, or add its differences
+        pendingPayload -= payload.size();
+        if (pendingOpcode == Opcode::Insert)
+            return writer.write(payload);
+        const auto read = pendingRead;
+        pendingRead += payload.size();
+        return writer.add(
+            sourceMemory.subrange(read, payload.size()), payload);
+    };
+    for (size_t block = 0ULL; block < blockHeader.m_blockCount; ++block) {
+        const auto blockSize = decompress_block(
+            diffData, blockHeader, blockEnds, block,
+            &window.charArray()[carried]);
+        if (blockSize == 0ULL)
+            return false; // Failure
+        const auto available = window.subrange(0ULL, carried + blockSize);
+        const auto isLastBlock = block + 1ULL == blockHeader.m_blockCount;
+
+        // Finish any insertion or addition spanning from the previous block
+        size_t byteIndex = std::min(pendingPayload, available.size());
+        if (!write_payload(available.subrange(0ULL, byteIndex)))
+            return false; // Failure
+
+        // Execute every instruction held in full
+        while (byteIndex < available.size()) {
+            const auto instructionIndex = byteIndex;
+            if (!read_instruction(available, byteIndex, cursor, instruction)) {
+                // Wait for the next block, unless the data is malformed
+                if (isLastBlock ||
+                    available.size() - instructionIndex >= maxInstructionSize)
+                    return false; // Failure
+                break;
+            }
+            if (!writer.seek(instruction.m_index))
+                return false; // Failure
+            const auto readsSource = instruction.m_opcode == Opcode::Copy ||
+                                     instruction.m_opcode == Opcode::Add;
+            if (readsSource &&
+                (instruction.m_offset > sourceMemory.size() ||
+                 instruction.m_length >
+                     sourceMemory.size() - instruction.m_offset))
+                return false; // Failure
+            if (instruction.m_opcode == Opcode::Copy) {
+                if (!writer.write(sourceMemory.subrange(
+                        instruction.m_offset, instruction.m_length)))
+                    return false; // Failure
+            } else if (instruction.m_opcode == Opcode::Repeat) {
+                if (!writer.fill(instruction.m_value, instruction.m_length))
+                    return false; // Failure
+            } else {
+                pendingOpcode = instruction.m_opcode;
+                pendingRead = instruction.m_offset;
+                pendingPayload = instruction.m_length;
+                const auto amount =
+                    std::min(pendingPayload, available.size() - byteIndex);
+                if (!write_payload(available.subrange(byteIndex, amount)))
+                    return false; // Failure
+                byteIndex += amount;
+            }
+        }
+
+        // Carry over any partial instruction
+        carried = available.size() - byteIndex;
+        std::memmove(window.bytes(), &window.bytes()[byteIndex], carried);
+    }
+    if (carried != 0ULL || pendingPayload != 0ULL)
+        return false; // Failure
+    return writer.finish();
+}
+
+// Protected Structures
+
+void Buffer::Deallocator::operator()(std::byte* const data) const noexcept {
+    m_resource->deallocate(data, m_size, alignof(std::max_align_t));
+}
+
+// Protected Methods
+
+Buffer::Data Buffer::allocate(const size_t& size) const {
+    return Data(
+        static_cast<std::byte*>(
+            m_resource->allocate(size, alignof(std::max_align_t))),
+        Deallocator{ m_resource, size });
+}
+
+void Buffer::expand(const size_t& size) {
+    // Create the data container if it is missing
+    if (m_data == nullptr) {
+        m_capacity = size * 2ULL;
+        m_data = allocate(m_capacity);
+        m_dataPtr = m_data.get();
+    }
+
+    // Check if our previous buffer is too small
+    else if (size > m_capacity) {
+        // Allocate new container
+        m_capacity = size * 2ULL;
+        auto newData = allocate(m_capacity);
+
+        // Copy over old data
+        std::copy(m_data.get(), m_data.get() + m_range, newData.get());
+
+        // Swap data containers
+        m_data.swap(newData);
+        m_dataPtr = m_data.get();
+    }
+
+    m_range = size;
+}
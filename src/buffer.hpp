@@ -3,38 +3,98 @@
 #define YATTA_BUFFER_H
 
 #include "memoryRange.hpp"
+#include <functional>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <type_traits>
 
 namespace yatta {
+/** Receives each piece of data produced by a stream, in order.
+Returning false aborts the stream. */
+using StreamSink = std::function<bool(const MemoryRange&)>;
+
+/** Compression level using the fast LZ4 match finder. */
+constexpr int FastCompression = 0;
+/** Highest compression level, searching the deepest for matches. Levels
+between favour ratio over speed, decompressing just as fast. */
+constexpr int MaxCompression = 12;
+
+/** Options controlling how a diff instruction set is generated. */
+struct DiffOptions {
+    /** The available match-finding engines. */
+    enum class Method {
+        /** Rolling-hash block index, fast and parallel. */
+        RollingHash,
+        /** Suffix array over the source, slower but finds longer matches. */
+        SuffixArray
+    };
+    /** The engine used to find regions shared by the source and target. */
+    Method m_method = Method::RollingHash;
+    /** Allow suffix array matches to extend through small differences, which
+    are then added onto the source byte-wise, such as executables where only
+    relative offsets have changed. */
+    bool m_approximate = false;
+    /** The level the instruction set is compressed at. */
+    int m_compressionLevel = FastCompression;
+    /** The resource the diff and its temporaries are allocated from, other
+    than the match tables of high level compression, which are made by each
+    worker thread from the default heap. It is only used from the calling
+    thread, so need not be thread-safe. */
+    std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
+};
+
 /** An expandable contiguous memory range, similar to a std::vector<std::byte>.
 Allocates double its size, and may reallocate when the size > capacity.
+Memory is drawn from a polymorphic memory resource, such as an arena.
 Inherits all memory range functions, and provides pushing, popping,
 compressing, expanding, diffing, and patching operations. */
 class Buffer : public MemoryRange {
     public:
+    // Public Types
+    /** The ways newly allocated memory can be initialized. */
+    enum class Init {
+        /** Zero every byte. */
+        Zeroed,
+        /** Leave the bytes indeterminate, to be overwritten by the caller. */
+        Uninitialized
+    };
+
     // Public (de)Constructors
     /** Destroy the buffer, freeing any allocated memory. */
     ~Buffer() = default;
     /** Construct an empty buffer. */
     Buffer() = default;
+    /** Construct an empty buffer, allocating from the specified resource.
+    @param  resource        the memory resource to allocate from. */
+    explicit Buffer(std::pmr::memory_resource* const resource) noexcept;
     /** Construct a buffer of the specified byte size.
     @param  size            the number of bytes to allocate. */
     explicit Buffer(const size_t& size);
-    /** Construct a buffer, copying from another buffer.
+    /** Construct a buffer of exactly the specified byte size, without any
+    spare capacity.
+    @param  size            the number of bytes to allocate.
+    @param  init            how to initialize the allocated bytes.
+    @param  resource        the memory resource to allocate from. */
+    Buffer(
+        const size_t& size, const Init& init,
+        std::pmr::memory_resource* const resource =
+            std::pmr::get_default_resource());
+    /** Construct a buffer, copying from another buffer into memory from the
+    default resource.
     @param  other           the buffer to copy from. */
     Buffer(const Buffer& other);
-    /** Construct a buffer, moving from another buffer.
+    /** Construct a buffer, moving from another buffer along with its memory
+    resource.
     @param  other           the buffer to move from. */
     Buffer(Buffer&& other) noexcept;
 
     // Public Assignment Operators
-    /** Copy-assignment operator.
+    /** Copy-assignment operator, keeping this buffer's memory resource.
     @param  other           the buffer to copy from.
     @return                 reference to this. */
     Buffer& operator=(const Buffer& other);
-    /** Move-assignment operator.
+    /** Move-assignment operator, adopting the other buffer's memory resource.
     @param  other           the buffer to move from.
     @return                 reference to this. */
     Buffer& operator=(Buffer&& other) noexcept;
@@ -47,9 +107,13 @@ class Buffer : public MemoryRange {
     /** Retrieve the total number of bytes allocated.
     @return                 the number of bytes allocated. */
     size_t capacity() const noexcept;
+    /** Retrieve the memory resource this buffer allocates from.
+    @return                 the memory resource in use. */
+    std::pmr::memory_resource* resource() const noexcept;
 
     // Public Manipulation Methods
     /** Change the size of this buffer, reallocating if size > capacity.
+    Any bytes added are zeroed.
     @note   will invalidate previous pointers when reallocating.
     @param  size            the new size to use. */
     void resize(const size_t& size);
@@ -75,7 +139,7 @@ class Buffer : public MemoryRange {
     @param  dataObject      the specific object to insert. */
     template <typename T> void push_type(const T& dataObj) {
         const auto byteIndex = m_range;
-        resize(m_range + sizeof(T));
+        expand(m_range + sizeof(T));
         // Only reinterpret-cast if T is not std::byte
         if constexpr (std::is_same<T, std::byte>::value)
             m_dataPtr[byteIndex] = dataObj;
@@ -112,20 +176,34 @@ class Buffer : public MemoryRange {
 
     // Public Derivation Methods
     /** Compresses the contents of this buffer into a new buffer.
+    @param  level           the compression level, from FastCompression to
+    MaxCompression.
     @return                 the compressed buffer on success, empty otherwise.
     */
-    [[nodiscard]] std::optional<Buffer> compress() const;
+    [[nodiscard]] std::optional<Buffer>
+    compress(const int& level = FastCompression) const;
     /** Compresses the contents of the supplied buffer into a new buffer.
     @param  buffer          the buffer to compress.
+    @param  level           the compression level, from FastCompression to
+    MaxCompression.
     @return                 the compressed buffer on success, empty otherwise.
     */
-    [[nodiscard]] static std::optional<Buffer> compress(const Buffer& buffer);
+    [[nodiscard]] static std::optional<Buffer>
+    compress(const Buffer& buffer, const int& level = FastCompression);
     /** Compresses the supplied memory range into a new buffer.
     @param  memoryRange     the memory range to compress.
+    @param  level           the compression level, from FastCompression to
+    MaxCompression.
+    @param  resource        the memory resource to allocate from.
+    @param  headroom        the number of bytes to leave free at the front of
+    the compressed buffer, so a header can be written in without copying.
     @return                 the compressed buffer on success, empty otherwise.
     */
-    [[nodiscard]] static std::optional<Buffer>
-    compress(const MemoryRange& memoryRange);
+    [[nodiscard]] static std::optional<Buffer> compress(
+        const MemoryRange& memoryRange, const int& level = FastCompression,
+        std::pmr::memory_resource* const resource =
+            std::pmr::get_default_resource(),
+        const size_t& headroom = 0ULL);
     /** Decompress the contents of this buffer into a new buffer.
     @return                 the decompressed buffer on success, empty otherwise.
     */
@@ -137,29 +215,38 @@ class Buffer : public MemoryRange {
     [[nodiscard]] static std::optional<Buffer> decompress(const Buffer& buffer);
     /** Decompress the supplied memory range into a new buffer.
     @param  memoryRange     the memory range to decompress.
+    @param  resource        the memory resource to allocate from.
     @return                 the decompressed buffer on success, empty otherwise.
     */
-    [[nodiscard]] static std::optional<Buffer>
-    decompress(const MemoryRange& memoryRange);
+    [[nodiscard]] static std::optional<Buffer> decompress(
+        const MemoryRange& memoryRange,
+        std::pmr::memory_resource* const resource =
+            std::pmr::get_default_resource());
     /** Diff this buffer against the supplied buffer, generating a patch
     instruction set.
     @param  target          the buffer to diff against.
+    @param  options         the options to generate the instructions with.
     @return                 the diff buffer on success, empty otherwise. */
-    [[nodiscard]] std::optional<Buffer> diff(const Buffer& target) const;
+    [[nodiscard]] std::optional<Buffer>
+    diff(const Buffer& target, const DiffOptions& options = {}) const;
     /** Diff the supplied buffers against each other, generating a patch
     instruction set.
     @param  sourceBuffer    the buffer to diff from.
     @param  targetBuffer    the buffer to diff against.
+    @param  options         the options to generate the instructions with.
     @return                 the diff buffer on success, empty otherwise. */
-    [[nodiscard]] static std::optional<Buffer>
-    diff(const Buffer& sourceBuffer, const Buffer& targetBuffer);
+    [[nodiscard]] static std::optional<Buffer> diff(
+        const Buffer& sourceBuffer, const Buffer& targetBuffer,
+        const DiffOptions& options = {});
     /** Diff the supplied memory ranges against each other, generating a patch
     instruction set.
     @param  sourceMemory    the range to diff from.
     @param  targetMemory    the range to diff against.
+    @param  options         the options to generate the instructions with.
     @return                 the diff buffer on success, empty otherwise. */
-    [[nodiscard]] static std::optional<Buffer>
-    diff(const MemoryRange& sourceMemory, const MemoryRange& targetMemory);
+    [[nodiscard]] static std::optional<Buffer> diff(
+        const MemoryRange& sourceMemory, const MemoryRange& targetMemory,
+        const DiffOptions& options = {});
     /** Patch the contents of this buffer into a new buffer, using the supplied
     diff buffer.
     @param  diffBuffer      the patch instruction set to use.
@@ -176,16 +263,57 @@ class Buffer : public MemoryRange {
     the supplied diff memory range.
     @param  sourceMemory    the source memory range to patch from.
     @param  diffMemory      the patch instruction set to use.
+    @param  resource        the memory resource the patched buffer and its
+    temporaries are allocated from, only used from the calling thread.
     @return                 the patched buffer on success, empty otherwise. */
-    [[nodiscard]] static std::optional<Buffer>
-    patch(const MemoryRange& sourceMemory, const MemoryRange& diffMemory);
+    [[nodiscard]] static std::optional<Buffer> patch(
+        const MemoryRange& sourceMemory, const MemoryRange& diffMemory,
+        std::pmr::memory_resource* const resource =
+            std::pmr::get_default_resource());
+    /** Patch the contents of the supplied memory range, sending the new data
+    to a sink in order rather than holding it all in memory at once.
+    @note   legacy "yatta diff" patches may write their instructions out of
+    order, so they are patched in memory first, then sent to the sink.
+    @param  sourceMemory    the source memory range to patch from.
+    @param  diffMemory      the patch instruction set to use.
+    @param  sink            the function receiving the patched data.
+    @return                 true on success, false otherwise. */
+    [[nodiscard]] static bool patch(
+        const MemoryRange& sourceMemory, const MemoryRange& diffMemory,
+        const StreamSink& sink);
 
     protected:
+    // Protected Friends
+    friend class BinaryWriter;
+
+    // Protected Structures
+    /** Returns memory to the resource it was allocated from. */
+    struct Deallocator {
+        std::pmr::memory_resource* m_resource;
+        size_t m_size;
+        void operator()(std::byte* const data) const noexcept;
+    };
+    /** Owning pointer to memory allocated from a memory resource. */
+    using Data = std::unique_ptr<std::byte[], Deallocator>;
+
+    // Protected Methods
+    /** Allocate memory from this buffer's resource, leaving it uninitialized.
+    @param  size            the number of bytes to allocate.
+    @return                 the allocated memory. */
+    Data allocate(const size_t& size) const;
+    /** Change the size of this buffer, reallocating if size > capacity,
+    leaving any bytes added uninitialized.
+    @note   will invalidate previous pointers when reallocating.
+    @param  size            the new size to use. */
+    void expand(const size_t& size);
+
     // Protected Attributes
     /** Size of memory allocated. */
     size_t m_capacity = 0ULL;
+    /** The memory resource allocated from. */
+    std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
     /** Underlying data pointer. */
-    std::unique_ptr<std::byte[]> m_data = nullptr;
+    Data m_data;
 };
 
 // Template Specializations
@@ -0,0 +1,194 @@
+#include "compressionStream.hpp"
+#include "lz4/lz4.h"
+#include <algorithm>
+#include <cstring>
+
+// Convenience Definitions
+using yatta::Buffer;
+using yatta::MemoryRange;
+using yatta::StreamCompressor;
+using yatta::StreamDecompressor;
+
+/** Data structures for compression stream headers. */
+struct StreamHeader {
+    char m_title[16ULL] = { '\0' };
+    size_t m_chunkSize = 0ULL;
+};
+/** Byte length of each chunk, matching the reach of an LZ4 match. */
+constexpr size_t StreamChunkSize = 65536ULL;
+/** Maximum byte length of a compressed chunk. */
+const size_t StreamChunkBound = static_cast<size_t>(
+    LZ4_compressBound(static_cast<int>(StreamChunkSize)));
+
+// StreamCompressor (de)constructors
+
+StreamCompressor::~StreamCompressor() { LZ4_freeStream(m_stream); }
+
+StreamCompressor::StreamCompressor(StreamSink sink)
+    : m_sink(std::move(sink)), m_stream(LZ4_createStream()),
+      m_chunks{ Buffer(StreamChunkSize, Buffer::Init::Uninitialized),
+                Buffer(StreamChunkSize, Buffer::Init::Uninitialized) },
+      m_output(sizeof(size_t) + StreamChunkBound) {
+    if (m_stream == nullptr)
+        throw std::bad_alloc();
+}
+
+// StreamCompressor Public Methods
+
+bool StreamCompressor::write(const MemoryRange& memoryRange) {
+    if (m_failed || m_finished)
+        return false; // Failure
+
+    // Fill chunks, compressing each one as it fills up
+    size_t index(0ULL);
+    while (index < memoryRange.size()) {
+        const auto amount = std::min(
+            StreamChunkSize - m_chunkFill, memoryRange.size() - index);
+        m_chunks[m_chunkIndex].in_raw(
+            &memoryRange.bytes()[index], amount, m_chunkFill);
+        m_chunkFill += amount;
+        index += amount;
+        if (m_chunkFill == StreamChunkSize && !flushChunk())
+            return false; // Failure
+    }
+    return true; // Success
+}
+
+bool StreamCompressor::finish() {
+    if (m_failed || m_finished)
+        return false; // Failure
+    if (m_chunkFill != 0ULL && !flushChunk())
+        return false; // Failure
+
+    // End with an empty chunk
+    m_finished = true;
+    constexpr size_t endMarker(0ULL);
+    m_output.in_type(endMarker);
+    return emit(m_output.subrange(0ULL, sizeof(size_t)));
+}
+
+// StreamCompressor Private Methods
+
+bool StreamCompressor::flushChunk() {
+    // Compress the chunk, after its size
+    const auto compressedSize = LZ4_compress_fast_continue(
+        m_stream, m_chunks[m_chunkIndex].charArray(),
+        &m_output.charArray()[sizeof(size_t)], static_cast<int>(m_chunkFill),
+        static_cast<int>(StreamChunkBound), 1);
+    if (compressedSize <= 0) {
+        m_failed = true;
+        return false; // Failure
+    }
+    m_output.in_type(static_cast<size_t>(compressedSize));
+
+    // Alternate chunks, keeping the previous one intact for reference
+    m_chunkIndex ^= 1ULL;
+    m_chunkFill = 0ULL;
+    return emit(m_output.subrange(
+        0ULL, sizeof(size_t) + static_cast<size_t>(compressedSize)));
+}
+
+bool StreamCompressor::emit(const MemoryRange& memoryRange) {
+    if (!m_started) {
+        m_started = true;
+        StreamHeader header{ "yatta stream", StreamChunkSize };
+        const MemoryRange headerRange(
+            sizeof(StreamHeader), reinterpret_cast<std::byte*>(&header));
+        if (!m_sink(headerRange)) {
+            m_failed = true;
+            return false; // Failure
+        }
+    }
+    if (!m_sink(memoryRange)) {
+        m_failed = true;
+        return false; // Failure
+    }
+    return true; // Success
+}
+
+// StreamDecompressor (de)constructors
+
+StreamDecompressor::~StreamDecompressor() { LZ4_freeStreamDecode(m_stream); }
+
+StreamDecompressor::StreamDecompressor(StreamSink sink)
+    : m_sink(std::move(sink)), m_stream(LZ4_createStreamDecode()),
+      m_chunks{ Buffer(StreamChunkSize, Buffer::Init::Uninitialized),
+                Buffer(StreamChunkSize, Buffer::Init::Uninitialized) },
+      m_stagedSize(sizeof(StreamHeader)) {
+    if (m_stream == nullptr)
+        throw std::bad_alloc();
+    m_input.reserve(StreamChunkBound);
+}
+
+// StreamDecompressor Public Methods
+
+bool StreamDecompressor::write(const MemoryRange& memoryRange) {
+    // Stage the stream's pieces, consuming each one once complete
+    size_t index(0ULL);
+    while (index < memoryRange.size()) {
+        if (m_failed || m_stage == Stage::Finished)
+            return false; // Failure
+        const auto amount = std::min(
+            m_stagedSize - m_input.size(), memoryRange.size() - index);
+        m_input.push_raw(&memoryRange.bytes()[index], amount);
+        index += amount;
+        if (m_input.size() == m_stagedSize && !consumeStaged()) {
+            m_failed = true;
+            return false; // Failure
+        }
+    }
+    return !m_failed;
+}
+
+bool StreamDecompressor::isFinished() const noexcept {
+    return m_stage == Stage::Finished;
+}
+
+// StreamDecompressor Private Methods
+
+bool StreamDecompressor::consumeStaged() {
+    switch (m_stage) {
+    case Stage::Header: {
+        // Ensure header title and chunk size match
+        StreamHeader header;
+        m_input.out_type(header);
+        if (std::strcmp(header.m_title, "yatta stream") != 0 ||
+            header.m_chunkSize != StreamChunkSize)
+            return false; // Failure
+        m_stage = Stage::ChunkSize;
+        m_stagedSize = sizeof(size_t);
+        break;
+    }
+    case Stage::ChunkSize: {
+        // An empty chunk ends the stream
+        size_t chunkSize(0ULL);
+        m_input.out_type(chunkSize);
+        if (chunkSize > StreamChunkBound)
+            return false; // Failure
+        m_stage = chunkSize == 0ULL ? Stage::Finished : Stage::Chunk;
+        m_stagedSize = chunkSize;
+        break;
+    }
+    case Stage::Chunk: {
+        // Decompress the chunk, alternating so the previous one stays intact
+        const auto decompressedSize = LZ4_decompress_safe_continue(
+            m_stream, m_input.charArray(), m_chunks[m_chunkIndex].charArray(),
+            static_cast<int>(m_input.size()),
+            static_cast<int>(StreamChunkSize));
+        if (decompressedSize <= 0)
+            return false; // Failure
+        const auto chunk = m_chunks[m_chunkIndex].subrange(
+            0ULL, static_cast<size_t>(decompressedSize));
+        m_chunkIndex ^= 1ULL;
+        if (!m_sink(chunk))
+            return false; // Failure
+        m_stage = Stage::ChunkSize;
+        m_stagedSize = sizeof(size_t);
+        break;
+    }
+    case Stage::Finished:
+        return false; // Failure
+    }
+    m_input.resize(0ULL);
+    return true; // Success
+}
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef YATTA_COMPRESSIONSTREAM_H
+#define YATTA_COMPRESSIONSTREAM_H
+
+#include "buffer.hpp"
+#include <array>
+
+// Forward Declarations
+union LZ4_stream_u;
+union LZ4_streamDecode_u;
+
+namespace yatta {
+/** Compresses data incrementally, in fixed-size chunks.
+Each chunk may reference the one before it, so the ratio approaches that of
+compressing the data whole, while memory stays bounded by the chunk size no
+matter how much data passes through. */
+class StreamCompressor {
+    public:
+    // Public (de)constructors
+    /** Destroy this compressor, without finishing the stream. */
+    ~StreamCompressor();
+    /** Construct a compressor writing its output to the specified sink.
+    @param  sink            the sink receiving the compressed stream. */
+    explicit StreamCompressor(StreamSink sink);
+    /** Deleted copy-assignment constructor. */
+    StreamCompressor(const StreamCompressor&) = delete;
+    /** Deleted move-assignment constructor. */
+    StreamCompressor(StreamCompressor&&) = delete;
+
+    // Public Assignment Operators
+    /** Deleted copy-assignment operator. */
+    StreamCompressor& operator=(const StreamCompressor& other) = delete;
+    /** Deleted move-assignment operator. */
+    StreamCompressor& operator=(StreamCompressor&& other) = delete;
+
+    // Public Methods
+    /** Append data to the stream, compressing every chunk it fills.
+    @param  memoryRange     the data to append.
+    @return                 true on success, false otherwise. */
+    bool write(const MemoryRange& memoryRange);
+    /** Compress any partially filled chunk and end the stream.
+    @return                 true on success, false otherwise. */
+    bool finish();
+
+    private:
+    // Private Methods
+    /** Compress the current chunk and send it to the sink.
+    @return                 true on success, false otherwise. */
+    bool flushChunk();
+    /** Send data to the sink, preceded by the stream header if not yet sent.
+    @param  memoryRange     the data to send.
+    @return                 true on success, false otherwise. */
+    bool emit(const MemoryRange& memoryRange);
+
+    // Private Attributes
+    StreamSink m_sink;
+    LZ4_stream_u* m_stream = nullptr;
+    std::array<Buffer, 2ULL> m_chunks;
+    Buffer m_output;
+    size_t m_chunkIndex = 0ULL, m_chunkFill = 0ULL;
+    bool m_started = false, m_finished = false, m_failed = false;
+};
+
+/** Decompresses a stream produced by a StreamCompressor incrementally.
+Accepts the compressed stream in pieces of any size, sending each chunk to the
+sink as soon as it is complete. */
+class StreamDecompressor {
+    public:
+    // Public (de)constructors
+    /** Destroy this decompressor. */
+    ~StreamDecompressor();
+    /** Construct a decompressor writing its output to the specified sink.
+    @param  sink            the sink receiving the decompressed data. */
+    explicit StreamDecompressor(StreamSink sink);
+    /** Deleted copy-assignment constructor. */
+    StreamDecompressor(const StreamDecompressor&) = delete;
+    /** Deleted move-assignment constructor. */
+    StreamDecompressor(StreamDecompressor&&) = delete;
+
+    // Public Assignment Operators
+    /** Deleted copy-assignment operator. */
+    StreamDecompressor& operator=(const StreamDecompressor& other) = delete;
+    /** Deleted move-assignment operator. */
+    StreamDecompressor& operator=(StreamDecompressor&& other) = delete;
+
+    // Public Methods
+    /** Consume the next piece of the compressed stream.
+    @param  memoryRange     the compressed data to consume.
+    @return                 true on success, false if the stream is malformed
+    or the sink failed. */
+    bool write(const MemoryRange& memoryRange);
+    /** Check if the end of the stream has been reached.
+    @return                 true if finished, false otherwise. */
+    bool isFinished() const noexcept;
+
+    private:
+    // Private Methods
+    /** Process the fully staged header, size, or chunk.
+    @return                 true on success, false otherwise. */
+    bool consumeStaged();
+
+    // Private Types
+    /** The portions of the stream, read in turn. */
+    enum class Stage { Header, ChunkSize, Chunk, Finished };
+
+    // Private Attributes
+    StreamSink m_sink;
+    LZ4_streamDecode_u* m_stream = nullptr;
+    std::array<Buffer, 2ULL> m_chunks;
+    Buffer m_input;
+    Stage m_stage = Stage::Header;
+    size_t m_chunkIndex = 0ULL, m_stagedSize = 0ULL;
+    bool m_failed = false;
+};
+}; // namespace yatta
+
+#endif // YATTA_COMPRESSIONSTREAM_H
@@ -1,158 +1,193 @@
 #include "directory.hpp"
+#include "binaryIO.hpp"
+#include "threader.hpp"
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <fstream>
+#include <mutex>
 #include <numeric>
+#include <string_view>
+#include <unordered_map>
 
 // Convenience definitions
+using yatta::BinaryReader;
+using yatta::BinaryWriter;
 using yatta::Buffer;
 using yatta::Directory;
+using yatta::MemoryRange;
+using yatta::SharedRange;
+using yatta::TaskGroup;
+using yatta::Threader;
 using filepath = std::filesystem::path;
 using directory_itt = std::filesystem::directory_iterator;
 using directory_rec_itt = std::filesystem::recursive_directory_iterator;
 using FileList = std::vector<Directory::VirtualFile>;
-using FilePairList =
-    std::vector<std::pair<Directory::VirtualFile, Directory::VirtualFile>>;
+using FileRefList = std::vector<const Directory::VirtualFile*>;
+using FilePairList = std::vector<
+    std::pair<const Directory::VirtualFile*, const Directory::VirtualFile*>>;
 struct FileInstruction {
-    std::string path, fullPath;
-    Buffer instructionBuffer;
+    std::string path, fullPath, sourcePath;
+    SharedRange instructionBuffer;
     size_t diff_oldHash = 0ULL, diff_newHash = 0ULL;
+    char flag = 0;
+    yatta::HashVersion hashVersion = yatta::HashVersion::Current;
 }; /** Contains diff instructions for a specific file. */
 
 // Private Static Methods
 
 /** Attempts to remove a file using an instruction. */
-constexpr auto find_file = [](const std::string& path, const size_t& hash,
+constexpr auto find_file = [](const FileInstruction& instruction,
                               auto& files) noexcept {
     return std::find_if(
-        files.begin(), files.end(), [&path, &hash](const auto& file) noexcept {
+        files.begin(), files.end(), [&instruction](const auto& file) noexcept {
             // Ensure file path and hash matches
-            return file.m_relativePath == path && file.m_data.hash() == hash;
+            return file.m_relativePath == instruction.path &&
+                   file.m_data.hash(instruction.hashVersion) ==
+                       instruction.diff_oldHash;
         });
 };
 
-/** Retrieve lists of a common, added, and deleted files. */
+/** Retrieve lists of a common, added, and deleted files, referring to the
+files rather than copying them. Old files are indexed by path, so each new file
+is matched in constant time. */
 auto get_file_lists(
     const FileList& srcOld_Files, const FileList& srcNew_Files) {
+    std::unordered_map<std::string_view, size_t> oldIndices;
+    oldIndices.reserve(srcOld_Files.size());
+    for (size_t oIndex = 0ULL; oIndex < srcOld_Files.size(); ++oIndex)
+        oldIndices.try_emplace(srcOld_Files[oIndex].m_relativePath, oIndex);
+
     FilePairList commonFiles;
-    FileList addFiles;
-    FileList delFiles = srcOld_Files;
+    FileRefList addFiles;
+    std::vector<bool> matched(srcOld_Files.size(), false);
     for (const auto& nFile : srcNew_Files) {
-        bool found = false;
-        size_t oIndex(0ULL);
-        for (const auto& oFile : delFiles) {
-            if (nFile.m_relativePath == oFile.m_relativePath) {
-                // Common file found
-                commonFiles.push_back({ oFile, nFile });
-
-                // Remove old file from list
-                delFiles.erase(delFiles.begin() + oIndex);
-                found = true;
-                break;
-            }
-            oIndex++;
-        }
-        // New file found, add it
-        if (!found)
-            addFiles.push_back(nFile);
+        if (const auto match = oldIndices.find(nFile.m_relativePath);
+            match != oldIndices.end() && !matched[match->second]) {
+            // Common file found
+            commonFiles.emplace_back(&srcOld_Files[match->second], &nFile);
+            matched[match->second] = true;
+        } else
+            // New file found, add it
+            addFiles.emplace_back(&nFile);
     }
 
-    return std::make_tuple(commonFiles, addFiles, delFiles);
+    // Any unmatched old files were deleted
+    FileRefList delFiles;
+    for (size_t oIndex = 0ULL; oIndex < srcOld_Files.size(); ++oIndex)
+        if (!matched[oIndex])
+            delFiles.emplace_back(&srcOld_Files[oIndex]);
+
+    return std::make_tuple(
+        std::move(commonFiles), std::move(addFiles), std::move(delFiles));
 }
 
-/** Virtualize a package buffer of files into a vector. */
-void in_files(
-    const Buffer& filebuffer, std::vector<Directory::VirtualFile>& files) {
-    // Find the file count
-    size_t byteIndex(0ULL);
+/** Virtualize a package buffer of files into a vector, aliasing each file's
+data within the package rather than copying it. Fails if any record is
+truncated. */
+bool in_files(
+    const SharedRange& filebuffer,
+    std::vector<Directory::VirtualFile>& files) {
+    // Find the file count, each file taking at least 3 sizes worth of bytes
+    BinaryReader reader(filebuffer);
     size_t fileCount(0ULL);
-    filebuffer.out_type(fileCount, byteIndex);
-    byteIndex += sizeof(size_t);
-
-    // Iterate over all files, writing out all their data
-    const auto packSize = filebuffer.size();
-    size_t fileIndex(files.size());
-    files.resize(files.size() + fileCount);
-    const auto finalSize = files.size();
-    while (byteIndex < packSize && fileIndex < finalSize) {
-        // Read the path string out of the archive
-        auto& file = files[fileIndex++];
-        filebuffer.out_type(file.m_relativePath, byteIndex);
-        byteIndex += sizeof(size_t) +
-                     (sizeof(char) * file.m_relativePath.size()) +
-                     sizeof(size_t);
-
-        // Write the file size in bytes, into the archive
+    if (!reader.read(fileCount))
+        return false; // Failure
+    files.reserve(
+        files.size() +
+        std::min<size_t>(
+            fileCount, reader.remaining() / (sizeof(size_t) * 3ULL)));
+
+    // Iterate over all files, failing at the first truncated record
+    for (size_t fileIndex = 0ULL; fileIndex < fileCount; ++fileIndex) {
+        std::string_view path;
         size_t bufferSize(0ULL);
-        filebuffer.out_type(bufferSize, byteIndex);
-        byteIndex += sizeof(size_t);
-
-        // Copy the file data
-        file.m_data.resize(bufferSize);
-        filebuffer.out_raw(file.m_data.bytes(), file.m_data.size(), byteIndex);
-        byteIndex += sizeof(std::byte) * file.m_data.size();
+        if (!reader.read_string(path) || !reader.read(bufferSize) ||
+            bufferSize > reader.remaining())
+            return false; // Failure
+
+        // Share the file data
+        files.push_back({ std::string(path),
+                          filebuffer.slice(reader.position(), bufferSize) });
+        reader.skip(bufferSize);
     }
+    return true; // Success
 }
 
 /** Attempt to patch a file using an instruction. */
 void patch_file(
     Directory::VirtualFile& file, const FileInstruction& instruction) {
     // Attempt patching and confirm new hashes match
-    if (auto result = file.m_data.patch(instruction.instructionBuffer);
-        result.has_value() && result->hash() == instruction.diff_newHash)
-        // Update virtualized folder
-        std::swap(file.m_data, *result);
+    auto result = Buffer::patch(file.m_data, instruction.instructionBuffer);
+    if (!result.has_value())
+        return;
+    SharedRange patchedData(std::move(*result));
+    if (patchedData.hash(instruction.hashVersion) == instruction.diff_newHash)
+        // Update virtualized folder, keeping the hash cached
+        file.m_data = std::move(patchedData);
 }
 
 /** Attempt to create a new file using an instruction. */
 std::optional<Directory::VirtualFile>
 add_file(const FileInstruction& instruction) {
     // Attempt to make a new file by patching an empty buffer
-    if (auto result = Buffer().patch(instruction.instructionBuffer);
-        result.has_value() && result->hash() == instruction.diff_newHash)
-        // Emplace the file
-        return Directory::VirtualFile{ instruction.path, std::move(*result) };
-    return {};
+    auto result = Buffer::patch(MemoryRange(), instruction.instructionBuffer);
+    if (!result.has_value())
+        return {}; // Failure
+    SharedRange newData(std::move(*result));
+    if (newData.hash(instruction.hashVersion) == instruction.diff_newHash)
+        // Emplace the file, keeping the hash cached
+        return Directory::VirtualFile{ instruction.path, std::move(newData) };
+    return {}; // Failure
 }
 
-/** Parse in instructions from a memory range, updating instruction vectors. */
-void in_instructions(
-    const Buffer& instructionBuffer, const size_t& expectedFileCount,
+/** Parse in instructions from a memory range, updating instruction vectors.
+Fails if any record is truncated. */
+bool in_instructions(
+    const SharedRange& instructionBuffer, const size_t& expectedFileCount,
+    const yatta::HashVersion& hashVersion,
     std::vector<FileInstruction>& diffInstructions,
     std::vector<FileInstruction>& addInstructions,
-    std::vector<FileInstruction>& removeInstructions) {
-    // Start reading diff file
-    const auto instBufSize = instructionBuffer.size();
-    for (size_t files = 0ULL, byteIndex = 0ULL;
-         files < expectedFileCount && byteIndex < instBufSize; ++files) {
+    std::vector<FileInstruction>& removeInstructions,
+    std::vector<FileInstruction>& moveInstructions) {
+    // Start reading diff file, failing at the first truncated record
+    BinaryReader reader(instructionBuffer);
+    for (size_t files = 0ULL; files < expectedFileCount; ++files) {
         // Accumulate attributes here
         FileInstruction instruction;
+        std::string_view path;
         char flag(0);
         size_t instructionSize(0ULL);
 
         // Read Attributes
-        instructionBuffer.out_type(instruction.path, byteIndex);
-        byteIndex += sizeof(size_t) +
-                     (sizeof(char) * instruction.path.length()) +
-                     sizeof(size_t);
-        instructionBuffer.out_type(flag, byteIndex);
-        byteIndex += sizeof(char);
-        instructionBuffer.out_type(instruction.diff_oldHash, byteIndex);
-        byteIndex += sizeof(size_t);
-        instructionBuffer.out_type(instruction.diff_newHash, byteIndex);
-        byteIndex += sizeof(size_t);
-        instructionBuffer.out_type(instructionSize, byteIndex);
-        byteIndex += sizeof(size_t);
+        if (!reader.read_string(path) ||
+            !reader.read(
+                flag, instruction.diff_oldHash, instruction.diff_newHash,
+                instructionSize) ||
+            instructionSize > reader.remaining())
+            return false; // Failure
+        instruction.path = path;
+        instruction.flag = flag;
+        instruction.hashVersion = hashVersion;
 
         // Check if instruction buffer's size is non-zero
         if (instructionSize != 0ULL) {
-            // Resize OUR buffer to fit
-            instruction.instructionBuffer.resize(instructionSize);
-            // Copy the buffer's data
-            instructionBuffer.out_raw(
-                instruction.instructionBuffer.bytes(), instructionSize,
-                byteIndex);
-            byteIndex += instructionSize;
+            // Share the buffer's data
+            instruction.instructionBuffer =
+                instructionBuffer.slice(reader.position(), instructionSize);
+            reader.skip(instructionSize);
+        }
+
+        // Moved and similar files lead with the path they were diffed against
+        if (flag == 'M' || flag == 'C') {
+            BinaryReader moveReader(instruction.instructionBuffer);
+            std::string_view sourcePath;
+            if (!moveReader.read_string(sourcePath))
+                return false; // Failure
+            instruction.sourcePath = sourcePath;
+            instruction.instructionBuffer =
+                instruction.instructionBuffer.slice(
+                    moveReader.position(), moveReader.remaining());
         }
 
         // Place the instruction in the correct container
@@ -162,14 +197,22 @@ void in_instructions(
             addInstructions.emplace_back(std::move(instruction));
         else if (flag == 'D')
             removeInstructions.emplace_back(std::move(instruction));
+        else if (flag == 'M' || flag == 'C')
+            moveInstructions.emplace_back(std::move(instruction));
     }
+    return true; // Success
 }
 
-/** Write out instructions into a buffer. */
+/** Write out instructions into a buffer. Moved and similar files lead their
+diff with the path they were diffed against. */
 void out_instruction(
     const std::string& path, const size_t& oldHash, const size_t& newHash,
-    const Buffer& buffer, const char& flag, Buffer& instructionBuffer) {
-    const auto bufferSize = buffer.size();
+    const MemoryRange& buffer, const char& flag, Buffer& instructionBuffer,
+    const std::string& sourcePath = "") {
+    const auto hasSource = flag == 'M' || flag == 'C';
+    const auto sourceSize =
+        hasSource ? (sizeof(size_t) * 2ULL) + sourcePath.length() : 0ULL;
+    const auto bufferSize = sourceSize + buffer.size();
     const auto pathLength = path.length();
     const size_t instructionSize = (sizeof(size_t) * 4ULL) +
                                    (sizeof(char) * pathLength) + sizeof(char) +
@@ -177,61 +220,440 @@ void out_instruction(
     instructionBuffer.reserve(instructionBuffer.size() + instructionSize);
 
     // Write Attributes
-    instructionBuffer.push_type(path);
-    instructionBuffer.push_type(flag);
-    instructionBuffer.push_type(oldHash);
-    instructionBuffer.push_type(newHash);
-    instructionBuffer.push_type(bufferSize);
-    if (bufferSize != 0ULL)
-        instructionBuffer.push_raw(
-            buffer.bytes(), sizeof(std::byte) * bufferSize);
+    BinaryWriter writer(instructionBuffer);
+    writer.write_string(path);
+    writer.write(flag, oldHash, newHash, bufferSize);
+    if (hasSource)
+        writer.write_string(sourcePath);
+    writer.write_raw(buffer.bytes(), sizeof(std::byte) * buffer.size());
+}
+
+/** Forwards allocations to another memory resource under a lock, so that
+resources which aren't thread-safe may be shared by parallel jobs. */
+class LockedResource final : public std::pmr::memory_resource {
+    public:
+    explicit LockedResource(std::pmr::memory_resource* const upstream) noexcept
+        : m_upstream(upstream) {}
+
+    private:
+    void* do_allocate(const size_t bytes, const size_t alignment) final {
+        std::unique_lock<std::mutex> guard(m_mutex);
+        return m_upstream->allocate(bytes, alignment);
+    }
+    void do_deallocate(
+        void* const pointer, const size_t bytes, const size_t alignment) final {
+        std::unique_lock<std::mutex> guard(m_mutex);
+        m_upstream->deallocate(pointer, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const
+        noexcept final {
+        return this == &other;
+    }
+    std::pmr::memory_resource* const m_upstream;
+    std::mutex m_mutex;
+};
+
+/** Files up to this many bytes in total are diffed together in one job. */
+constexpr size_t DiffBatchSize = 1024ULL * 1024ULL;
+
+/** Retrieve the number of bytes a pair of files holds. */
+size_t pair_size(const FilePairList::value_type& filePair) noexcept {
+    return (filePair.first != nullptr ? filePair.first->m_data.size() : 0ULL) +
+           filePair.second->m_data.size();
+}
+
+/** Check if a file is identical to the old file it's diffed against, comparing
+sizes before hashes so that most differing files are caught without hashing
+them. */
+bool is_identical(
+    const Directory::VirtualFile* const oldFile,
+    const Directory::VirtualFile* const newFile) noexcept {
+    return oldFile != nullptr &&
+           oldFile->m_data.size() == newFile->m_data.size() &&
+           oldFile->m_data.hash() == newFile->m_data.hash();
+}
+
+/** Files smaller than this many bytes are only found similar to other files
+if identical, or if moved. */
+constexpr size_t SketchMinimumSize = 4096ULL;
+/** The number of chunk hashes kept per file, the smallest ones. */
+constexpr size_t SketchSize = 32ULL;
+/** Chunks end where the top 8 bits of the rolling hash are zero, making them
+roughly 256 bytes long. The low bits only depend on the last few bytes. */
+constexpr uint64_t ChunkMask = (256ULL - 1ULL) << 56U;
+/** Sketches must share at least 1 in this many of the hashes sampled for their
+files to be diffed against each other. */
+constexpr size_t SimilarityRatio = 4ULL;
+
+/** Random values for each byte, rolled into the hash that splits files into
+chunks. Generated with splitmix64, so they're the same on every platform. */
+constexpr auto GearTable = []() noexcept {
+    std::array<uint64_t, 256ULL> table{};
+    uint64_t state(0ULL);
+    for (auto& value : table) {
+        state += 0x9E3779B97F4A7C15ULL;
+        auto mixed = state;
+        mixed = (mixed ^ (mixed >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        mixed = (mixed ^ (mixed >> 27U)) * 0x94D049BB133111EBULL;
+        value = mixed ^ (mixed >> 31U);
+    }
+    return table;
+}();
+
+/** Summarize a file's contents as the smallest hashes of its chunks, sorted.
+Chunk boundaries depend only on the bytes before them, so an insertion only
+disturbs the chunks around it. */
+std::vector<size_t> make_sketch(const MemoryRange& data) {
+    std::vector<size_t> sketch;
+    const auto* const bytes = data.bytes();
+    uint64_t gear(0ULL);
+    for (size_t index = 0ULL, chunkBegin = 0ULL; index < data.size();
+         ++index) {
+        gear = (gear << 1U) + GearTable[static_cast<uint8_t>(bytes[index])];
+        if ((gear & ChunkMask) == 0ULL || index + 1ULL == data.size()) {
+            sketch.emplace_back(
+                data.subrange(chunkBegin, index + 1ULL - chunkBegin).hash());
+            chunkBegin = index + 1ULL;
+        }
+    }
+    std::sort(sketch.begin(), sketch.end());
+    sketch.erase(std::unique(sketch.begin(), sketch.end()), sketch.end());
+    if (sketch.size() > SketchSize)
+        sketch.resize(SketchSize);
+    return sketch;
+}
+
+/** Estimate how similar 2 files are from their sketches, as the number of
+hashes shared amongst the smallest hashes of both, and that number. */
+std::pair<size_t, size_t> compare_sketches(
+    const std::vector<size_t>& sketchA,
+    const std::vector<size_t>& sketchB) noexcept {
+    size_t shared(0ULL);
+    size_t count(0ULL);
+    auto itA = sketchA.cbegin();
+    auto itB = sketchB.cbegin();
+    while (count < SketchSize &&
+           (itA != sketchA.cend() || itB != sketchB.cend())) {
+        if (itB == sketchB.cend() || (itA != sketchA.cend() && *itA < *itB))
+            ++itA;
+        else if (itA == sketchA.cend() || *itB < *itA)
+            ++itB;
+        else {
+            ++shared;
+            ++itA;
+            ++itB;
+        }
+        ++count;
+    }
+    return { shared, count };
+}
+
+/** Pair deleted files with the added files they were moved or renamed to,
+removing them from both lists. Identical contents are matched first, then
+matching file names whose contents are similar, which are diffed against each
+other. */
+FilePairList find_moves(FileRefList& addedFiles, FileRefList& removedFiles) {
+    // Hash every candidate up front, in parallel
+    const auto addedCount = addedFiles.size();
+    Threader::GetShared().parallel_for(
+        0ULL, addedCount + removedFiles.size(), [&](const size_t& index) {
+            (index < addedCount ? addedFiles[index]
+                                : removedFiles[index - addedCount])
+                ->m_data.hash();
+        });
+
+    // Index the deleted files by their contents and names, in order
+    std::unordered_map<size_t, std::vector<size_t>> hashIndices;
+    std::unordered_map<std::string, std::vector<size_t>> nameIndices;
+    for (size_t rIndex = 0ULL; rIndex < removedFiles.size(); ++rIndex) {
+        const auto& rFile = *removedFiles[rIndex];
+        hashIndices[rFile.m_data.hash()].emplace_back(rIndex);
+        nameIndices[filepath(rFile.m_relativePath).filename().string()]
+            .emplace_back(rIndex);
+    }
+
+    // Claim the first deleted file of a set that suits an added file
+    std::vector<const Directory::VirtualFile*> sources(addedCount, nullptr);
+    std::vector<bool> moved(removedFiles.size(), false);
+    std::vector<std::vector<size_t>> sketches(
+        addedCount + removedFiles.size());
+    const auto is_similar = [&](const size_t& aIndex, const size_t& rIndex) {
+        const auto [shared, count] =
+            compare_sketches(sketches[aIndex], sketches[addedCount + rIndex]);
+        return shared > 0ULL && shared * SimilarityRatio >= count;
+    };
+    const auto claim = [&](const size_t& aIndex, const auto& indices,
+                           const bool& identical) {
+        if (indices == nullptr)
+            return;
+        for (const auto& rIndex : *indices) {
+            if (moved[rIndex] ||
+                (identical
+                     ? !is_identical(removedFiles[rIndex], addedFiles[aIndex])
+                     : !is_similar(aIndex, rIndex)))
+                continue;
+            moved[rIndex] = true;
+            sources[aIndex] = removedFiles[rIndex];
+            return;
+        }
+    };
+    const auto find_indices = [](const auto& map, const auto& key) {
+        const auto match = map.find(key);
+        return match != map.end() ? &match->second : nullptr;
+    };
+    for (size_t aIndex = 0ULL; aIndex < addedCount; ++aIndex)
+        claim(
+            aIndex,
+            find_indices(hashIndices, addedFiles[aIndex]->m_data.hash()),
+            true);
+
+    // Sketch the files that may still be paired by name, in parallel
+    std::vector<const std::vector<size_t>*> nameMatches(addedCount, nullptr);
+    std::vector<bool> needsSketch(sketches.size(), false);
+    for (size_t aIndex = 0ULL; aIndex < addedCount; ++aIndex) {
+        if (sources[aIndex] != nullptr)
+            continue;
+        nameMatches[aIndex] = find_indices(
+            nameIndices,
+            filepath(addedFiles[aIndex]->m_relativePath).filename().string());
+        if (nameMatches[aIndex] == nullptr)
+            continue;
+        needsSketch[aIndex] = true;
+        for (const auto& rIndex : *nameMatches[aIndex])
+            if (!moved[rIndex])
+                needsSketch[addedCount + rIndex] = true;
+    }
+    Threader::GetShared().parallel_for(
+        0ULL, sketches.size(), [&](const size_t& index) {
+            if (needsSketch[index])
+                sketches[index] = make_sketch(
+                    (index < addedCount ? addedFiles[index]
+                                        : removedFiles[index - addedCount])
+                        ->m_data);
+        });
+    for (size_t aIndex = 0ULL; aIndex < addedCount; ++aIndex)
+        claim(aIndex, nameMatches[aIndex], false);
+
+    // Split off the moved files, keeping the rest in order
+    FilePairList moves;
+    FileRefList stillAdded;
+    FileRefList stillRemoved;
+    for (size_t aIndex = 0ULL; aIndex < addedCount; ++aIndex)
+        if (sources[aIndex] != nullptr)
+            moves.emplace_back(sources[aIndex], addedFiles[aIndex]);
+        else
+            stillAdded.emplace_back(addedFiles[aIndex]);
+    for (size_t rIndex = 0ULL; rIndex < removedFiles.size(); ++rIndex)
+        if (!moved[rIndex])
+            stillRemoved.emplace_back(removedFiles[rIndex]);
+    addedFiles = std::move(stillAdded);
+    removedFiles = std::move(stillRemoved);
+    return moves;
+}
+
+/** Pair added files with the most similar old file to diff against, removing
+them from the added list. Identical files are matched by hash, others by
+sketches of their chunks. */
+FilePairList find_similar(FileRefList& addedFiles, const FileList& oldFiles) {
+    // Sketch every candidate up front, in parallel
+    const auto addedCount = addedFiles.size();
+    std::vector<std::vector<size_t>> addedSketches(addedCount);
+    std::vector<std::vector<size_t>> oldSketches(oldFiles.size());
+    Threader::GetShared().parallel_for(
+        0ULL, addedCount + oldFiles.size(), [&](const size_t& index) {
+            const auto& data = index < addedCount
+                                   ? addedFiles[index]->m_data
+                                   : oldFiles[index - addedCount].m_data;
+            data.hash();
+            if (data.size() >= SketchMinimumSize)
+                (index < addedCount ? addedSketches[index]
+                                    : oldSketches[index - addedCount]) =
+                    make_sketch(data);
+        });
+
+    // Index the old files by their contents and chunks, in order
+    std::unordered_map<size_t, size_t> hashIndices;
+    std::unordered_map<size_t, std::vector<size_t>> chunkIndices;
+    for (size_t oIndex = 0ULL; oIndex < oldFiles.size(); ++oIndex) {
+        hashIndices.try_emplace(oldFiles[oIndex].m_data.hash(), oIndex);
+        for (const auto& chunkHash : oldSketches[oIndex])
+            chunkIndices[chunkHash].emplace_back(oIndex);
+    }
+
+    // Find the best match for each added file, preferring earlier old files
+    std::vector<const Directory::VirtualFile*> bases(addedCount, nullptr);
+    Threader::GetShared().parallel_for(
+        0ULL, addedCount, [&](const size_t& aIndex) {
+            const auto& aFile = *addedFiles[aIndex];
+            if (const auto match = hashIndices.find(aFile.m_data.hash());
+                match != hashIndices.end() &&
+                is_identical(&oldFiles[match->second], &aFile)) {
+                bases[aIndex] = &oldFiles[match->second];
+                return;
+            }
+            std::vector<size_t> candidates;
+            for (const auto& chunkHash : addedSketches[aIndex])
+                if (const auto match = chunkIndices.find(chunkHash);
+                    match != chunkIndices.end())
+                    candidates.insert(
+                        candidates.end(), match->second.begin(),
+                        match->second.end());
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(
+                std::unique(candidates.begin(), candidates.end()),
+                candidates.end());
+            size_t bestShared(0ULL);
+            size_t bestCount(1ULL);
+            for (const auto& oIndex : candidates) {
+                const auto [shared, count] = compare_sketches(
+                    addedSketches[aIndex], oldSketches[oIndex]);
+                if (shared * SimilarityRatio >= count &&
+                    shared * bestCount > bestShared * count) {
+                    bestShared = shared;
+                    bestCount = count;
+                    bases[aIndex] = &oldFiles[oIndex];
+                }
+            }
+        });
+
+    // Split off the similar files, keeping the rest in order
+    FilePairList similarFiles;
+    FileRefList stillAdded;
+    for (size_t aIndex = 0ULL; aIndex < addedCount; ++aIndex)
+        if (bases[aIndex] != nullptr)
+            similarFiles.emplace_back(bases[aIndex], addedFiles[aIndex]);
+        else
+            stillAdded.emplace_back(addedFiles[aIndex]);
+    addedFiles = std::move(stillAdded);
+    return similarFiles;
 }
 
 /** Generate diff instructions from a set of src and dst files. */
-auto gen_instructions(const FileList& srcFiles, const FileList& dstFiles) {
+auto gen_instructions(
+    const FileList& srcFiles, const FileList& dstFiles, const int& level,
+    std::pmr::memory_resource* resource, Directory::DeltaStats& stats) {
     // Retrieve all common, added, and removed files
     auto [commonFiles, addedFiles, removedFiles] =
         get_file_lists(srcFiles, dstFiles);
 
-    // These files are common, maybe some have changed
-    Buffer instructionBuffer;
+    auto movedFiles = find_moves(addedFiles, removedFiles);
+    auto similarFiles = addedFiles.empty()
+                            ? FilePairList()
+                            : find_similar(addedFiles, srcFiles);
+
+    // Diff common files, moved files, similar files and brand new files in
+    // parallel, the latter against nothing, with results kept in order so the
+    // output is deterministic
+    const auto commonCount = commonFiles.size();
+    const auto moveEnd = commonCount + movedFiles.size();
+    const auto similarEnd = moveEnd + similarFiles.size();
+    FilePairList diffPairs = std::move(commonFiles);
+    diffPairs.insert(diffPairs.end(), movedFiles.begin(), movedFiles.end());
+    movedFiles.clear();
+    diffPairs.insert(
+        diffPairs.end(), similarFiles.begin(), similarFiles.end());
+    similarFiles.clear();
+    for (const auto* nFile : addedFiles)
+        diffPairs.emplace_back(nullptr, nFile);
+    addedFiles.clear();
+
+    // Guard the resource with a lock, unless it's already thread-safe, ahead of
+    // the diffs allocated from it so that it outlives them
+    LockedResource lockedResource(resource);
+    yatta::DiffOptions options;
+    options.m_compressionLevel = level;
+    options.m_resource = resource == std::pmr::new_delete_resource()
+                             ? resource
+                             : &lockedResource;
+    std::vector<std::optional<Buffer>> diffBuffers(diffPairs.size());
+    TaskGroup group;
+    for (size_t begin = 0ULL, end = 0ULL; begin < diffPairs.size();
+         begin = end) {
+        // Batch small files together, giving large files a task of their own
+        // that their diff splits up further
+        size_t batchSize(0ULL);
+        do {
+            batchSize += pair_size(diffPairs[end++]);
+        } while (end < diffPairs.size() &&
+                 batchSize + pair_size(diffPairs[end]) <= DiffBatchSize);
+        group.run([&, begin, end]() {
+            const MemoryRange emptyRange;
+            for (auto index = begin; index < end; ++index) {
+                const auto& [oldFile, newFile] = diffPairs[index];
+                if (is_identical(oldFile, newFile))
+                    continue;
+                const auto& oldData =
+                    oldFile != nullptr
+                        ? static_cast<const MemoryRange&>(oldFile->m_data)
+                        : emptyRange;
+                diffBuffers[index] =
+                    Buffer::diff(oldData, newFile->m_data, options);
+
+                // Cache the hashes while the data is fresh in memory
+                if (oldFile != nullptr)
+                    oldFile->m_data.hash();
+                newFile->m_data.hash();
+            }
+        });
+    }
+    group.wait();
+
+    // Write out changed common files, moved files, similar files, then brand
+    // new files
+    Buffer instructionBuffer(resource);
     size_t instCount(0ULL);
-    for (const auto& [oldFile, newFile] : commonFiles) {
-        // Check if a common file has changed
-        const auto diffBuffer = oldFile.m_data.diff(newFile.m_data);
-        const auto oldHash = oldFile.m_data.hash();
-        const auto newHash = newFile.m_data.hash();
-        if (diffBuffer.has_value() && oldHash != newHash) {
-            out_instruction(
-                oldFile.m_relativePath, oldHash, newHash, *diffBuffer, 'U',
-                instructionBuffer);
-            instCount++;
+    for (size_t index = 0ULL; index < diffPairs.size(); ++index) {
+        const auto& [oldFile, newFile] = diffPairs[index];
+        const auto& diffBuffer = diffBuffers[index];
+        const auto isIdentical = is_identical(oldFile, newFile);
+        auto flag = 'N';
+        if (index < commonCount)
+            flag = 'U';
+        else if (index < moveEnd)
+            flag = 'M';
+        else if (index < similarEnd)
+            flag = 'C';
+        if (flag == 'U' && isIdentical) {
+            stats.m_filesUnchanged++;
+            continue;
         }
-    }
-    commonFiles.clear();
-
-    // These files are brand new
-    for (const auto& nFile : addedFiles) {
-        if (const auto diffBuffer = Buffer().diff(nFile.m_data)) {
-            out_instruction(
-                nFile.m_relativePath, 0ULL, nFile.m_data.hash(), *diffBuffer,
-                'N', instructionBuffer);
-            instCount++;
+        if (!isIdentical && !diffBuffer.has_value()) {
+            // Moved files still need their old path deleted
+            if (flag == 'M')
+                removedFiles.emplace_back(oldFile);
+            continue;
         }
+        const auto oldHash = oldFile != nullptr ? oldFile->m_data.hash() : 0ULL;
+        const auto newHash = newFile->m_data.hash();
+        out_instruction(
+            newFile->m_relativePath, oldHash, newHash,
+            isIdentical ? MemoryRange() : MemoryRange(*diffBuffer), flag,
+            instructionBuffer,
+            oldFile != nullptr ? oldFile->m_relativePath : "");
+        if (flag == 'U')
+            stats.m_filesChanged++;
+        else if (flag == 'M')
+            stats.m_filesMoved++;
+        else if (flag == 'C')
+            stats.m_filesSimilar++;
+        else
+            stats.m_filesAdded++;
+        instCount++;
     }
-    addedFiles.clear();
+    diffBuffers.clear();
 
     // These files are deprecated
-    for (const auto& oFile : removedFiles) {
+    for (const auto* oFile : removedFiles) {
         out_instruction(
-            oFile.m_relativePath, oFile.m_data.hash(), 0ULL, Buffer(), 'D',
-            instructionBuffer);
+            oFile->m_relativePath, oFile->m_data.hash(), 0ULL, MemoryRange(),
+            'D', instructionBuffer);
+        stats.m_filesRemoved++;
         instCount++;
     }
     removedFiles.clear();
 
     // Success
-    return std::make_pair(instructionBuffer, instCount);
+    return std::make_pair(std::move(instructionBuffer), instCount);
 }
 
 /** Modify files based on the input instruction set. */
@@ -239,12 +661,43 @@ void apply_instructions(
     std::vector<FileInstruction>& diffFiles,
     std::vector<FileInstruction>& addedFiles,
     std::vector<FileInstruction>& removedFiles,
+    std::vector<FileInstruction>& movedFiles,
     std::vector<Directory::VirtualFile>& files) {
+    // Find where moved and similar files came from, before anything is
+    // modified
+    const auto is_source = [](const FileInstruction& inst) {
+        return [&inst](const Directory::VirtualFile& file) noexcept {
+            return file.m_relativePath == inst.sourcePath &&
+                   file.m_data.hash(inst.hashVersion) == inst.diff_oldHash;
+        };
+    };
+    std::vector<Directory::VirtualFile> newFiles;
+    std::vector<const FileInstruction*> newFileMoves;
+    for (const auto& inst : movedFiles) {
+        const auto source =
+            std::find_if(files.cbegin(), files.cend(), is_source(inst));
+        if (source == files.cend())
+            continue;
+
+        // Patch the old file, unless it was moved or copied as-is
+        auto data = source->m_data;
+        if (inst.instructionBuffer.hasData()) {
+            auto result = Buffer::patch(data, inst.instructionBuffer);
+            if (!result.has_value())
+                continue;
+            data = SharedRange(std::move(*result));
+        }
+        if (data.hash(inst.hashVersion) == inst.diff_newHash) {
+            newFiles.push_back({ inst.path, std::move(data) });
+            newFileMoves.emplace_back(&inst);
+        }
+    }
+
     // Patch all files first
     std::for_each(
         diffFiles.cbegin(), diffFiles.cend(), [&](const FileInstruction& inst) {
             // Try to find the target file
-            if (auto dFile = find_file(inst.path, inst.diff_oldHash, files);
+            if (auto dFile = find_file(inst, files);
                 dFile != files.end())
                 patch_file(*dFile, inst);
         });
@@ -255,8 +708,7 @@ void apply_instructions(
         addedFiles.cbegin(), addedFiles.cend(),
         [&](const FileInstruction& inst) {
             // Erase any instances of this file
-            const auto prevFile =
-                find_file(inst.path, inst.diff_oldHash, files);
+            const auto prevFile = find_file(inst, files);
             if (prevFile != files.end())
                 files.erase(prevFile);
             // Attempt to make a new file
@@ -275,11 +727,34 @@ void apply_instructions(
                     files.begin(), files.end(),
                     [&](const Directory::VirtualFile& file) noexcept {
                         return file.m_relativePath == inst.path &&
-                               file.m_data.hash() == inst.diff_oldHash;
+                               file.m_data.hash(inst.hashVersion) ==
+                                   inst.diff_oldHash;
                     }),
                 files.end());
         });
     removedFiles.clear();
+
+    // Delete moved files from where they were, keeping the files similar
+    // files were diffed against, then place them anew
+    for (const auto* inst : newFileMoves) {
+        if (inst->flag != 'M')
+            continue;
+        if (const auto source =
+                std::find_if(files.begin(), files.end(), is_source(*inst));
+            source != files.end())
+            files.erase(source);
+    }
+    for (auto& newFile : newFiles) {
+        files.erase(
+            std::remove_if(
+                files.begin(), files.end(),
+                [&](const Directory::VirtualFile& file) noexcept {
+                    return file.m_relativePath == newFile.m_relativePath;
+                }),
+            files.end());
+        files.emplace_back(std::move(newFile));
+    }
+    movedFiles.clear();
 }
 
 // Public (de)Constructors
@@ -311,14 +786,18 @@ size_t Directory::fileSize() const noexcept {
         });
 }
 
-size_t Directory::hash() const noexcept {
+size_t Directory::hash() const {
     // May overflow, but that's okay as long as the accumulation order is the
     // same such that 2 copies of the same directory result in the same hash
-    return std::accumulate(
-        m_files.begin(), m_files.end(), yatta::ZeroHash,
-        [](const size_t& currentHash, const VirtualFile& file) noexcept {
-            return currentHash + file.m_data.hash();
-        });
+    return yatta::ZeroHash +
+           Threader::GetShared().parallel_reduce(
+               0ULL, m_files.size(), 0ULL,
+               [&](const size_t& index) noexcept {
+                   return m_files[index].m_data.hash();
+               },
+               [](const size_t& hashA, const size_t& hashB) noexcept {
+                   return hashA + hashB;
+               });
 }
 
 #ifdef __GNUC__
@@ -364,26 +843,34 @@ bool Directory::in_folder(
         return paths;
     };
 
+    // Read in every file, leaving this directory untouched if any can't be
+    std::vector<VirtualFile> files;
     for (const auto& entry : get_file_paths(path, exclusions)) {
         if (entry.is_regular_file()) {
-            // Read the file data
-            Buffer fileBuffer(entry.file_size());
+            // Read the file data, which must fill the whole buffer as it
+            // starts out uninitialized. Files are read rather than mapped, as
+            // a directory is often written back over the folder it came from.
+            Buffer fileBuffer(
+                entry.file_size(), Buffer::Init::Uninitialized);
             const std::string path_string = entry.path().string();
             constexpr std::ios_base::openmode mode =
                 std::ios_base::in | std::ios_base::binary;
             std::ifstream fileOnDisk = std::ifstream(path_string, mode);
-            assert(fileOnDisk.is_open());
-
-            fileOnDisk.read(
-                fileBuffer.charArray(),
-                static_cast<std::streamsize>(fileBuffer.size()));
+            const auto fileSize =
+                static_cast<std::streamsize>(fileBuffer.size());
+            if (!fileOnDisk.read(fileBuffer.charArray(), fileSize) ||
+                fileOnDisk.gcount() != fileSize)
+                return false; // Failure
             fileOnDisk.close();
 
-            m_files.emplace_back(VirtualFile{
+            files.emplace_back(VirtualFile{
                 (std::filesystem::relative(entry.path(), path)).string(),
-                std::move(fileBuffer) });
+                SharedRange(std::move(fileBuffer)) });
         }
     }
+    m_files.insert(
+        m_files.end(), std::make_move_iterator(files.begin()),
+        std::make_move_iterator(files.end()));
 
     return true; // Success
 }
@@ -394,26 +881,32 @@ bool Directory::in_package(const Buffer& packageBuffer) {
         return false; // Failure
 
     // Read in header
+    BinaryReader reader(packageBuffer);
     char packHeaderTitle[16ULL] = { '\0' };
-    std::string packHeaderName;
-    size_t byteIndex = sizeof(packHeaderTitle);
-    packageBuffer.out_type(packHeaderTitle);
-    packageBuffer.out_type(packHeaderName, byteIndex);
-    byteIndex += sizeof(size_t) + (sizeof(char) * packHeaderName.size()) +
-                 sizeof(size_t);
+    std::string_view packHeaderName;
+    if (!reader.read(packHeaderTitle) || !reader.read_string(packHeaderName))
+        return false; // Failure
 
     // Ensure header title matches
-    if (std::strcmp(packHeaderTitle, "yatta pack") != 0)
+    if (std::strncmp(packHeaderTitle, "yatta pack", sizeof(packHeaderTitle)) !=
+        0)
         return false; // Failure
 
     // Try to decompress the archive buffer
-    auto filebuffer = Buffer::decompress(
-        packageBuffer.subrange(byteIndex, packageBuffer.size() - byteIndex));
+    MemoryRange archive;
+    reader.read_range(reader.remaining(), archive);
+    auto filebuffer = Buffer::decompress(archive);
     if (!filebuffer.has_value())
         return false; // Failure
 
-    // Parse and read-in the packaged files
-    in_files(*filebuffer, m_files);
+    // Parse and read-in the packaged files, which share the archive's memory,
+    // leaving this directory untouched if the archive is damaged
+    std::vector<VirtualFile> files;
+    if (!in_files(SharedRange(std::move(*filebuffer)), files))
+        return false; // Failure
+    m_files.insert(
+        m_files.end(), std::make_move_iterator(files.begin()),
+        std::make_move_iterator(files.end()));
 
     // Success
     return true;
@@ -425,33 +918,47 @@ bool Directory::in_delta(const Buffer& deltaBuffer) {
         return false; // Failure
 
     // Read in header
+    BinaryReader reader(deltaBuffer);
     char deltaHeaderTitle[16ULL] = { '\0' };
+    auto hashVersion = yatta::HashVersion::Legacy;
     size_t deltaHeaderFileCount(0ULL);
-    size_t byteIndex = sizeof(deltaHeaderTitle);
-    deltaBuffer.out_type(deltaHeaderTitle);
-    deltaBuffer.out_type(deltaHeaderFileCount, byteIndex);
-    byteIndex += sizeof(size_t);
+    if (!reader.read(deltaHeaderTitle))
+        return false; // Failure
 
-    // Ensure header title matches
-    if (std::strcmp(deltaHeaderTitle, "yatta delta") != 0)
+    // Ensure header title matches, legacy deltas lacking a hash version
+    if (std::strncmp(
+            deltaHeaderTitle, "yatta delta v2", sizeof(deltaHeaderTitle)) ==
+        0) {
+        if (!reader.read(hashVersion, deltaHeaderFileCount) ||
+            (hashVersion != yatta::HashVersion::Legacy &&
+             hashVersion != yatta::HashVersion::XXH3))
+            return false; // Failure
+    } else if (
+        std::strncmp(
+            deltaHeaderTitle, "yatta delta", sizeof(deltaHeaderTitle)) != 0 ||
+        !reader.read(deltaHeaderFileCount))
         return false; // Failure
 
     // Try to decompress the instruction buffer
-    const auto instructionBuffer = Buffer::decompress(
-        deltaBuffer.subrange(byteIndex, deltaBuffer.size() - byteIndex));
+    MemoryRange instructions;
+    reader.read_range(reader.remaining(), instructions);
+    auto instructionBuffer = Buffer::decompress(instructions);
     if (!instructionBuffer.has_value())
-        return false;
+        return false; // Failure
 
-    // Parse and acquire instructions
+    // Parse and acquire instructions, applying none if any are damaged
     std::vector<FileInstruction> diffFiles;
     std::vector<FileInstruction> addedFiles;
     std::vector<FileInstruction> removedFiles;
-    in_instructions(
-        *instructionBuffer, deltaHeaderFileCount, diffFiles, addedFiles,
-        removedFiles);
+    std::vector<FileInstruction> movedFiles;
+    if (!in_instructions(
+            SharedRange(std::move(*instructionBuffer)), deltaHeaderFileCount,
+            hashVersion, diffFiles, addedFiles, removedFiles, movedFiles))
+        return false; // Failure
 
     // Consume and apply instructions
-    apply_instructions(diffFiles, addedFiles, removedFiles, m_files);
+    apply_instructions(
+        diffFiles, addedFiles, removedFiles, movedFiles, m_files);
     return true;
 }
 
@@ -478,8 +985,8 @@ bool Directory::out_folder(const filepath& path) const {
     return true; // Success
 }
 
-std::optional<Buffer>
-Directory::out_package(const std::string& folderName) const {
+std::optional<Buffer> Directory::out_package(
+    const std::string& folderName, const int& level) const {
     // Ensure we have files to output
     if (m_files.empty())
         return {}; // Failure
@@ -498,66 +1005,69 @@ Directory::out_package(const std::string& folderName) const {
         }));
 
     // Starting with the file count
-    filebuffer.push_type(m_files.size());
+    BinaryWriter writer(filebuffer);
+    writer.write(m_files.size());
 
     // Iterate over all files, writing in all their data
     for (auto& file : m_files) {
-        filebuffer.push_type(file.m_relativePath);
-        filebuffer.push_type(file.m_data.size());
-        filebuffer.push_raw(file.m_data.bytes(), file.m_data.size());
+        writer.write_string(file.m_relativePath);
+        writer.write(file.m_data.size());
+        writer.write_raw(file.m_data.bytes(), file.m_data.size());
     }
 
-    // Try to compress the archive buffer
-    if (auto result = filebuffer.compress())
-        std::swap(filebuffer, *result);
-    else
-        return {}; // Failure
-
-    // Prepend header information
+    // Try to compress the archive buffer, leaving room for the header
     constexpr char packHeaderTitle[16ULL] = "yatta pack\0";
     const auto& packHeaderName = folderName;
     const size_t headerSize = sizeof(packHeaderTitle) + sizeof(size_t) +
                               (sizeof(char) * folderName.size()) +
                               sizeof(size_t);
-    Buffer bufferWithHeader;
-    bufferWithHeader.reserve(filebuffer.size() + headerSize);
+    auto bufferWithHeader = Buffer::compress(
+        filebuffer, level, std::pmr::get_default_resource(), headerSize);
+    if (!bufferWithHeader.has_value())
+        return {}; // Failure
 
-    // Copy header data into new buffer at the beginning
-    bufferWithHeader.push_type(packHeaderTitle);
-    bufferWithHeader.push_type(packHeaderName);
-    bufferWithHeader.push_raw(filebuffer.bytes(), filebuffer.size());
+    // Write header data into the room left at the beginning, with the name's
+    // size repeated for backwards reading
+    bufferWithHeader->in_type(packHeaderTitle);
+    bufferWithHeader->in_type(packHeaderName, sizeof(packHeaderTitle));
+    bufferWithHeader->in_type(
+        packHeaderName.size(), headerSize - sizeof(size_t));
 
     return bufferWithHeader; // Success
 }
 
-std::optional<Buffer>
-Directory::out_delta(const Directory& targetDirectory) const {
+std::optional<Buffer> Directory::out_delta(
+    const Directory& targetDirectory, const int& level,
+    std::pmr::memory_resource* const resource, DeltaStats* const stats) const {
     // Ensure we have files to diff
     if (fileCount() == 0 && targetDirectory.fileCount() == 0)
         return {}; // Failure
 
     // Retrieve all common, added, and removed files as instructions
-    auto [instructionBuffer, instCount] =
-        gen_instructions(m_files, targetDirectory.m_files);
-
-    // Try to compress the instruction buffer
-    if (auto result = instructionBuffer.compress())
-        std::swap(instructionBuffer, *result);
-    else
+    DeltaStats deltaStats;
+    auto [instructionBuffer, instCount] = gen_instructions(
+        m_files, targetDirectory.m_files, level, resource, deltaStats);
+    if (stats != nullptr)
+        *stats = deltaStats;
+
+    // Try to compress the instruction buffer, leaving room for the header
+    constexpr char deltaHeaderTitle[16ULL] = "yatta delta v2";
+    constexpr auto deltaHeaderHashVersion = yatta::HashVersion::Current;
+    const auto& deltaHeaderFileCount = instCount;
+    constexpr size_t headerSize = sizeof(deltaHeaderTitle) +
+                                  sizeof(deltaHeaderHashVersion) +
+                                  sizeof(size_t);
+    auto bufferWithHeader =
+        Buffer::compress(instructionBuffer, level, resource, headerSize);
+    if (!bufferWithHeader.has_value())
         return {}; // Failure
 
-    // Prepend header information
-    constexpr char deltaHeaderTitle[16ULL] = "yatta delta";
-    const auto& deltaHeaderFileCount = instCount;
-    constexpr size_t headerSize = sizeof(deltaHeaderTitle) + sizeof(size_t);
-    Buffer bufferWithHeader;
-    bufferWithHeader.reserve(instructionBuffer.size() + headerSize);
-
-    // Copy header data into new buffer at the beginning
-    bufferWithHeader.push_type(deltaHeaderTitle);
-    bufferWithHeader.push_type(deltaHeaderFileCount);
-    bufferWithHeader.push_raw(
-        instructionBuffer.bytes(), instructionBuffer.size());
+    // Write header data into the room left at the beginning
+    bufferWithHeader->in_type(deltaHeaderTitle);
+    bufferWithHeader->in_type(deltaHeaderHashVersion, sizeof(deltaHeaderTitle));
+    bufferWithHeader->in_type(
+        deltaHeaderFileCount,
+        sizeof(deltaHeaderTitle) + sizeof(deltaHeaderHashVersion));
 
     return bufferWithHeader; // Success
 }
\ No newline at end of file
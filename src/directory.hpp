@@ -3,6 +3,7 @@
 #define DIRECTORY_H
 
 #include "buffer.hpp"
+#include "sharedRange.hpp"
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -13,10 +14,29 @@ Has functions for compressing, decompressing, diffing, and patching. */
 class Directory {
     public:
     // Public Structures
-    /** File data and path container. */
+    /** File data and path container. Data read from a package aliases the
+    package's memory, which is kept alive for as long as any file uses it. */
     struct VirtualFile {
         std::string m_relativePath = "";
-        Buffer m_data;
+        SharedRange m_data;
+    };
+    /** Counts of how each file was handled while generating a delta. */
+    struct DeltaStats {
+        /** Common files skipped without diffing, their size and hash being
+        unchanged. */
+        size_t m_filesUnchanged = 0ULL;
+        /** Common files that changed, diffed against their old versions. */
+        size_t m_filesChanged = 0ULL;
+        /** Files moved or renamed, diffed against their old versions unless
+        unchanged. */
+        size_t m_filesMoved = 0ULL;
+        /** New files resembling an old file, diffed against the most similar
+        one, which is kept. */
+        size_t m_filesSimilar = 0ULL;
+        /** Brand new files, diffed against nothing. */
+        size_t m_filesAdded = 0ULL;
+        /** Files no longer present. */
+        size_t m_filesRemoved = 0ULL;
     };
 
     // Public (de)Constructors
@@ -65,9 +85,10 @@ class Directory {
     directory. */
     size_t fileSize() const noexcept;
     /** Generates a hash value derived from this directory's contents.
+    @note   will throw if the files' hashing jobs can't be scheduled.
     @return                 hash value for this directory, derived from its
     buffers. */
-    size_t hash() const noexcept;
+    size_t hash() const;
     /** Retrieve the running directory for this application.
     @return                 the directory this application launched from. */
     static std::string GetRunningDirectory() noexcept;
@@ -77,7 +98,8 @@ class Directory {
     void clear() noexcept;
 
     // Public IO Methods
-    /** Copies in the files found on disk at the path specified.
+    /** Copies in the files found on disk at the path specified, leaving this
+    directory untouched if any of them can't be read in full.
     @param  path            the path to look for files at.
     @param  exclusions      list of filenames/types to skip. "string" matches
     relative path, ".ext" matches extension.
@@ -85,12 +107,13 @@ class Directory {
     bool in_folder(
         const std::filesystem::path& path,
         const std::vector<std::string>& exclusions = {});
-    /** Parses and expands the contents of a package into this directory.
+    /** Parses and expands the contents of a package into this directory,
+    leaving it unchanged if the package is damaged.
     @param  packageBuffer   the package to source data from.
     @return                 true on success, false otherwise. */
     bool in_package(const Buffer& packageBuffer);
     /** Updates and patches the files in this directory using the specified
-    patch file.
+    patch file, leaving it unchanged if the patch is damaged.
     @param  deltaBuffer     the patch to apply.
     @return                 true on success, false otherwise. */
     bool in_delta(const Buffer& deltaBuffer);
@@ -101,14 +124,32 @@ class Directory {
     bool out_folder(const std::filesystem::path& path) const;
     /** Generate a package buffer from this directory.
     @param  folderName      the name to give this package.
+    @param  level           the compression level, from FastCompression to
+    MaxCompression.
     @return                 packaged version of this directory on success, empty
     otherwise. */
-    std::optional<Buffer> out_package(const std::string& folderName) const;
+    std::optional<Buffer> out_package(
+        const std::string& folderName,
+        const int& level = FastCompression) const;
     /** Generate a patch buffer from this directory against the specified target
-    directory.
+    directory. Files are diffed in parallel, yet the patch is the same for any
+    number of threads.
     @param  targetDirectory the target to diff against.
+    @param  level           the compression level, from FastCompression to
+    MaxCompression.
+    @param  resource        the memory resource the patch buffer, each file's
+    diff and the diffs' temporaries are allocated from, such as an arena
+    released afterwards. Unless it is the new-delete resource, it is accessed
+    under a lock, so need not be thread-safe. The lists pairing files up and the
+    match tables of high level compression still use the default heap.
+    @param  stats           optional pointer to counts to fill in, describing
+    how each file was handled.
     @return                 patch buffer on success, empty otherwise. */
-    std::optional<Buffer> out_delta(const Directory& targetDirectory) const;
+    std::optional<Buffer> out_delta(
+        const Directory& targetDirectory, const int& level = FastCompression,
+        std::pmr::memory_resource* const resource =
+            std::pmr::get_default_resource(),
+        DeltaStats* const stats = nullptr) const;
 
     protected:
     // Protected Attributes
@@ -0,0 +1,702 @@
+#include "hasher.hpp"
+#include "threader.hpp"
+#include <algorithm>
+#include <cstring>
+
+// SIMD kernels available on this platform
+#if defined(__x86_64__) || defined(_M_X64)
+#define YATTA_XXH3_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define YATTA_TARGET_AVX2
+#else
+#define YATTA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define YATTA_XXH3_NEON
+#include <arm_neon.h>
+#endif
+
+// Convenience Definitions
+using yatta::Hasher;
+using yatta::HashVersion;
+using yatta::MemoryRange;
+using yatta::Threader;
+
+/** The number of bytes per chunk of a tree hash, larger ranges being hashed
+as a tree of chunks. */
+constexpr size_t TreeHashChunk = 4ULL * 1024ULL * 1024ULL;
+/** The number of chunk digests computed in parallel at once, kept on the stack
+so that tree hashing never allocates. */
+constexpr size_t TreeHashBatch = 64ULL;
+/** The number of bytes consumed by each step of XXH3's accumulators. */
+constexpr size_t StripeSize = 64ULL;
+/** The number of stripes between scrambles of XXH3's accumulators. */
+constexpr size_t BlockStripes = 16ULL;
+/** The largest input XXH3 hashes without its accumulators. */
+constexpr size_t MidSizeMax = 240ULL;
+/** xxHash's 32 and 64-bit primes. */
+constexpr std::uint64_t Prime32_1 = 0x9E3779B1ULL;
+constexpr std::uint64_t Prime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t Prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t Prime64_3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t PrimeMX1 = 0x165667919E3779F9ULL;
+constexpr std::uint64_t PrimeMX2 = 0x9FB21C651E98DF25ULL;
+/** The initial values of XXH3's accumulators. */
+constexpr std::uint64_t InitialAccumulators[8] = {
+    0x00000000C2B2AE3DULL, 0x9E3779B185EBCA87ULL, 0xC2B2AE3D27D4EB4FULL,
+    0x165667B19E3779F9ULL, 0x85EBCA77C2B2AE63ULL, 0x0000000085EBCA77ULL,
+    0x27D4EB2F165667C5ULL, 0x000000009E3779B1ULL
+};
+/** XXH3's default secret, keying every step of the hash. */
+alignas(64) constexpr unsigned char SecretBytes[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+/** The offset of the secret used to scramble XXH3's accumulators. */
+constexpr size_t ScrambleSecret = sizeof(SecretBytes) - StripeSize;
+
+/** Kernels running XXH3's accumulator loop, one set per instruction set. */
+struct XXH3Kernels {
+    /** Accumulate a number of consecutive stripes, keyed by consecutive 8-byte
+    steps of the secret. */
+    void (*accumulate)(
+        std::uint64_t* accumulators, const std::byte* dataPtr,
+        const std::byte* secretPtr, size_t stripeCount) noexcept;
+    /** Scramble the accumulators at the end of a block. */
+    void (*scramble)(
+        std::uint64_t* accumulators, const std::byte* secretPtr) noexcept;
+};
+
+// Private Static Methods
+
+/** Retrieve a pointer into XXH3's secret. */
+const std::byte* xxh3_secret(const size_t& offset) noexcept {
+    return &reinterpret_cast<const std::byte*>(SecretBytes)[offset];
+}
+
+/** Rotate a value's bits left. */
+constexpr std::uint64_t rotate_left(
+    const std::uint64_t& value, const unsigned int& bits) noexcept {
+    return (value << bits) | (value >> (64U - bits));
+}
+
+/** Read an unaligned value from memory. */
+template <typename T> T read_value(const std::byte* const dataPtr) noexcept {
+    T value;
+    std::memcpy(&value, dataPtr, sizeof(T));
+    return value;
+}
+
+/** Multiply two 64-bit values into 128 bits, folding the halves together. */
+std::uint64_t
+mul128_fold64(const std::uint64_t& lhs, const std::uint64_t& rhs) noexcept {
+#if defined(__SIZEOF_INT128__)
+    const auto product = static_cast<unsigned __int128>(lhs) * rhs;
+    return static_cast<std::uint64_t>(product) ^
+           static_cast<std::uint64_t>(product >> 64U);
+#else
+    constexpr std::uint64_t LowMask = 0xFFFFFFFFULL;
+    const auto lowLow = (lhs & LowMask) * (rhs & LowMask);
+    const auto highLow = (lhs >> 32U) * (rhs & LowMask);
+    const auto lowHigh = (lhs & LowMask) * (rhs >> 32U);
+    const auto highHigh = (lhs >> 32U) * (rhs >> 32U);
+    const auto cross = (lowLow >> 32U) + (highLow & LowMask) + lowHigh;
+    const auto upper = (highLow >> 32U) + (cross >> 32U) + highHigh;
+    const auto lower = (cross << 32U) | (lowLow & LowMask);
+    return lower ^ upper;
+#endif
+}
+
+/** Swap the byte order of a value. */
+constexpr std::uint64_t swap_bytes(std::uint64_t value) noexcept {
+    value = ((value & 0x00FF00FF00FF00FFULL) << 8U) |
+            ((value >> 8U) & 0x00FF00FF00FF00FFULL);
+    value = ((value & 0x0000FFFF0000FFFFULL) << 16U) |
+            ((value >> 16U) & 0x0000FFFF0000FFFFULL);
+    return (value << 32U) | (value >> 32U);
+}
+
+/** Scramble the bits of XXH64's final hash. */
+constexpr std::uint64_t xxh64_avalanche(std::uint64_t hash) noexcept {
+    hash ^= hash >> 33U;
+    hash *= Prime64_2;
+    hash ^= hash >> 29U;
+    hash *= Prime64_3;
+    return hash ^ (hash >> 32U);
+}
+
+/** Scramble the bits of XXH3's final hash. */
+constexpr std::uint64_t xxh3_avalanche(std::uint64_t hash) noexcept {
+    hash ^= hash >> 37U;
+    hash *= PrimeMX1;
+    return hash ^ (hash >> 32U);
+}
+
+/** Mix 16 bytes of input with 16 bytes of the secret. */
+std::uint64_t xxh3_mix16(
+    const std::byte* const dataPtr, const std::byte* const secretPtr) noexcept {
+    return mul128_fold64(
+        read_value<std::uint64_t>(dataPtr) ^
+            read_value<std::uint64_t>(secretPtr),
+        read_value<std::uint64_t>(&dataPtr[8]) ^
+            read_value<std::uint64_t>(&secretPtr[8]));
+}
+
+/** Hash up to 16 bytes. */
+std::uint64_t
+xxh3_short(const std::byte* const dataPtr, const size_t& size) noexcept {
+    if (size > 8ULL) {
+        const auto low = read_value<std::uint64_t>(dataPtr) ^
+                         (read_value<std::uint64_t>(xxh3_secret(24ULL)) ^
+                          read_value<std::uint64_t>(xxh3_secret(32ULL)));
+        const auto high = read_value<std::uint64_t>(&dataPtr[size - 8ULL]) ^
+                          (read_value<std::uint64_t>(xxh3_secret(40ULL)) ^
+                           read_value<std::uint64_t>(xxh3_secret(48ULL)));
+        return xxh3_avalanche(
+            size + swap_bytes(low) + high + mul128_fold64(low, high));
+    }
+    if (size >= 4ULL) {
+        const auto first = read_value<std::uint32_t>(dataPtr);
+        const auto last = read_value<std::uint32_t>(&dataPtr[size - 4ULL]);
+        auto hash = (last + (static_cast<std::uint64_t>(first) << 32U)) ^
+                    (read_value<std::uint64_t>(xxh3_secret(8ULL)) ^
+                     read_value<std::uint64_t>(xxh3_secret(16ULL)));
+        hash ^= rotate_left(hash, 49U) ^ rotate_left(hash, 24U);
+        hash *= PrimeMX2;
+        hash ^= (hash >> 35U) + size;
+        hash *= PrimeMX2;
+        return hash ^ (hash >> 28U);
+    }
+    if (size > 0ULL) {
+        const auto combined =
+            (static_cast<std::uint32_t>(dataPtr[0]) << 16U) |
+            (static_cast<std::uint32_t>(dataPtr[size >> 1U]) << 24U) |
+            static_cast<std::uint32_t>(dataPtr[size - 1ULL]) |
+            (static_cast<std::uint32_t>(size) << 8U);
+        return xxh64_avalanche(
+            combined ^ static_cast<std::uint64_t>(
+                           read_value<std::uint32_t>(xxh3_secret(0ULL)) ^
+                           read_value<std::uint32_t>(xxh3_secret(4ULL))));
+    }
+    return xxh64_avalanche(
+        read_value<std::uint64_t>(xxh3_secret(56ULL)) ^
+        read_value<std::uint64_t>(xxh3_secret(64ULL)));
+}
+
+/** Hash up to 240 bytes, without XXH3's accumulators. */
+std::uint64_t
+xxh3_medium(const std::byte* const dataPtr, const size_t& size) noexcept {
+    if (size <= 16ULL)
+        return xxh3_short(dataPtr, size);
+    auto hash = size * Prime64_1;
+    if (size <= 128ULL) {
+        // Mix pairs of 16 bytes from either end, working inwards
+        const auto pairs = (size - 1ULL) / 32ULL;
+        for (size_t pair = 0ULL; pair <= pairs; ++pair) {
+            hash += xxh3_mix16(
+                &dataPtr[pair * 16ULL], xxh3_secret(pair * 32ULL));
+            hash += xxh3_mix16(
+                &dataPtr[size - ((pair + 1ULL) * 16ULL)],
+                xxh3_secret((pair * 32ULL) + 16ULL));
+        }
+        return xxh3_avalanche(hash);
+    }
+
+    // Mix the first 128 bytes, then the rest against an offset secret
+    for (size_t round = 0ULL; round < 8ULL; ++round)
+        hash += xxh3_mix16(&dataPtr[round * 16ULL], xxh3_secret(round * 16ULL));
+    hash = xxh3_avalanche(hash);
+    auto endHash = xxh3_mix16(&dataPtr[size - 16ULL], xxh3_secret(119ULL));
+    for (size_t round = 8ULL; round < size / 16ULL; ++round)
+        endHash += xxh3_mix16(
+            &dataPtr[round * 16ULL],
+            xxh3_secret(((round - 8ULL) * 16ULL) + 3ULL));
+    return xxh3_avalanche(hash + endHash);
+}
+
+/** Accumulate stripes 8 bytes at a time. */
+void xxh3_accumulate_scalar(
+    std::uint64_t* const accumulators, const std::byte* dataPtr,
+    const std::byte* secretPtr, size_t stripeCount) noexcept {
+    for (; stripeCount > 0ULL; --stripeCount) {
+        for (size_t lane = 0ULL; lane < 8ULL; ++lane) {
+            const auto data = read_value<std::uint64_t>(&dataPtr[lane * 8ULL]);
+            const auto key =
+                data ^ read_value<std::uint64_t>(&secretPtr[lane * 8ULL]);
+            accumulators[lane ^ 1ULL] += data;
+            accumulators[lane] += (key & 0xFFFFFFFFULL) * (key >> 32U);
+        }
+        dataPtr += StripeSize;
+        secretPtr += 8ULL;
+    }
+}
+
+/** Scramble the accumulators 8 bytes at a time. */
+void xxh3_scramble_scalar(
+    std::uint64_t* const accumulators,
+    const std::byte* const secretPtr) noexcept {
+    for (size_t lane = 0ULL; lane < 8ULL; ++lane) {
+        auto accumulator = accumulators[lane];
+        accumulator ^= accumulator >> 47U;
+        accumulator ^= read_value<std::uint64_t>(&secretPtr[lane * 8ULL]);
+        accumulators[lane] = accumulator * Prime32_1;
+    }
+}
+
+#if defined(YATTA_XXH3_X86)
+/** Accumulate stripes 16 bytes at a time, using SSE2. */
+void xxh3_accumulate_sse2(
+    std::uint64_t* const accumulators, const std::byte* dataPtr,
+    const std::byte* secretPtr, size_t stripeCount) noexcept {
+    auto* const accumulatorPtr = reinterpret_cast<__m128i*>(accumulators);
+    __m128i lanes[4];
+    for (size_t lane = 0ULL; lane < 4ULL; ++lane)
+        lanes[lane] = _mm_load_si128(&accumulatorPtr[lane]);
+    for (; stripeCount > 0ULL; --stripeCount) {
+        for (size_t lane = 0ULL; lane < 4ULL; ++lane) {
+            const auto data = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(&dataPtr[lane * 16ULL]));
+            const auto key = _mm_xor_si128(
+                data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                          &secretPtr[lane * 16ULL])));
+            const auto product =
+                _mm_mul_epu32(key, _mm_shuffle_epi32(key, 0x31));
+            lanes[lane] = _mm_add_epi64(
+                _mm_add_epi64(lanes[lane], _mm_shuffle_epi32(data, 0x4E)),
+                product);
+        }
+        dataPtr += StripeSize;
+        secretPtr += 8ULL;
+    }
+    for (size_t lane = 0ULL; lane < 4ULL; ++lane)
+        _mm_store_si128(&accumulatorPtr[lane], lanes[lane]);
+}
+
+/** Scramble the accumulators 16 bytes at a time, using SSE2. */
+void xxh3_scramble_sse2(
+    std::uint64_t* const accumulators,
+    const std::byte* const secretPtr) noexcept {
+    auto* const accumulatorPtr = reinterpret_cast<__m128i*>(accumulators);
+    const auto prime = _mm_set1_epi32(static_cast<int>(Prime32_1));
+    for (size_t lane = 0ULL; lane < 4ULL; ++lane) {
+        auto accumulator = _mm_load_si128(&accumulatorPtr[lane]);
+        accumulator =
+            _mm_xor_si128(accumulator, _mm_srli_epi64(accumulator, 47));
+        accumulator = _mm_xor_si128(
+            accumulator, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                             &secretPtr[lane * 16ULL])));
+        const auto low = _mm_mul_epu32(accumulator, prime);
+        const auto high =
+            _mm_mul_epu32(_mm_shuffle_epi32(accumulator, 0x31), prime);
+        _mm_store_si128(
+            &accumulatorPtr[lane],
+            _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+    }
+}
+
+/** Accumulate stripes 32 bytes at a time, using AVX2. */
+YATTA_TARGET_AVX2 void xxh3_accumulate_avx2(
+    std::uint64_t* const accumulators, const std::byte* dataPtr,
+    const std::byte* secretPtr, size_t stripeCount) noexcept {
+    auto* const accumulatorPtr = reinterpret_cast<__m256i*>(accumulators);
+    __m256i lanes[2];
+    for (size_t lane = 0ULL; lane < 2ULL; ++lane)
+        lanes[lane] = _mm256_load_si256(&accumulatorPtr[lane]);
+    for (; stripeCount > 0ULL; --stripeCount) {
+        for (size_t lane = 0ULL; lane < 2ULL; ++lane) {
+            const auto data = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(&dataPtr[lane * 32ULL]));
+            const auto key = _mm256_xor_si256(
+                data, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                          &secretPtr[lane * 32ULL])));
+            const auto product =
+                _mm256_mul_epu32(key, _mm256_shuffle_epi32(key, 0x31));
+            lanes[lane] = _mm256_add_epi64(
+                _mm256_add_epi64(lanes[lane], _mm256_shuffle_epi32(data, 0x4E)),
+                product);
+        }
+        dataPtr += StripeSize;
+        secretPtr += 8ULL;
+    }
+    for (size_t lane = 0ULL; lane < 2ULL; ++lane)
+        _mm256_store_si256(&accumulatorPtr[lane], lanes[lane]);
+}
+
+/** Scramble the accumulators 32 bytes at a time, using AVX2. */
+YATTA_TARGET_AVX2 void xxh3_scramble_avx2(
+    std::uint64_t* const accumulators,
+    const std::byte* const secretPtr) noexcept {
+    auto* const accumulatorPtr = reinterpret_cast<__m256i*>(accumulators);
+    const auto prime = _mm256_set1_epi32(static_cast<int>(Prime32_1));
+    for (size_t lane = 0ULL; lane < 2ULL; ++lane) {
+        auto accumulator = _mm256_load_si256(&accumulatorPtr[lane]);
+        accumulator =
+            _mm256_xor_si256(accumulator, _mm256_srli_epi64(accumulator, 47));
+        accumulator = _mm256_xor_si256(
+            accumulator, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                             &secretPtr[lane * 32ULL])));
+        const auto low = _mm256_mul_epu32(accumulator, prime);
+        const auto high =
+            _mm256_mul_epu32(_mm256_shuffle_epi32(accumulator, 0x31), prime);
+        _mm256_store_si256(
+            &accumulatorPtr[lane],
+            _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+    }
+}
+
+/** Check if the running CPU and OS support AVX2. */
+bool cpu_has_avx2() noexcept {
+#if defined(_MSC_VER)
+    int info[4] = { 0, 0, 0, 0 };
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    // The OS must save the upper halves of the vector registers too
+    __cpuid(info, 1);
+    constexpr int OSXSave = 1 << 27, AVX = 1 << 28;
+    if ((info[2] & (OSXSave | AVX)) != (OSXSave | AVX) ||
+        (_xgetbv(0) & 0x6ULL) != 0x6ULL)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#elif defined(YATTA_XXH3_NEON)
+/** Accumulate stripes 16 bytes at a time, using NEON. */
+void xxh3_accumulate_neon(
+    std::uint64_t* const accumulators, const std::byte* dataPtr,
+    const std::byte* secretPtr, size_t stripeCount) noexcept {
+    uint64x2_t lanes[4];
+    for (size_t lane = 0ULL; lane < 4ULL; ++lane)
+        lanes[lane] = vld1q_u64(&accumulators[lane * 2ULL]);
+    for (; stripeCount > 0ULL; --stripeCount) {
+        for (size_t lane = 0ULL; lane < 4ULL; ++lane) {
+            const auto data = vreinterpretq_u64_u8(vld1q_u8(
+                reinterpret_cast<const uint8_t*>(&dataPtr[lane * 16ULL])));
+            const auto key = veorq_u64(
+                data, vreinterpretq_u64_u8(vld1q_u8(reinterpret_cast<
+                                                    const uint8_t*>(
+                          &secretPtr[lane * 16ULL]))));
+            lanes[lane] = vaddq_u64(lanes[lane], vextq_u64(data, data, 1));
+            lanes[lane] =
+                vmlal_u32(lanes[lane], vmovn_u64(key), vshrn_n_u64(key, 32));
+        }
+        dataPtr += StripeSize;
+        secretPtr += 8ULL;
+    }
+    for (size_t lane = 0ULL; lane < 4ULL; ++lane)
+        vst1q_u64(&accumulators[lane * 2ULL], lanes[lane]);
+}
+
+/** Scramble the accumulators 16 bytes at a time, using NEON. */
+void xxh3_scramble_neon(
+    std::uint64_t* const accumulators,
+    const std::byte* const secretPtr) noexcept {
+    const auto prime = vdup_n_u32(static_cast<std::uint32_t>(Prime32_1));
+    for (size_t lane = 0ULL; lane < 4ULL; ++lane) {
+        auto accumulator = vld1q_u64(&accumulators[lane * 2ULL]);
+        accumulator = veorq_u64(accumulator, vshrq_n_u64(accumulator, 47));
+        accumulator = veorq_u64(
+            accumulator,
+            vreinterpretq_u64_u8(vld1q_u8(
+                reinterpret_cast<const uint8_t*>(&secretPtr[lane * 16ULL]))));
+        const auto high =
+            vshlq_n_u64(vmull_u32(vshrn_n_u64(accumulator, 32), prime), 32);
+        vst1q_u64(
+            &accumulators[lane * 2ULL],
+            vmlal_u32(high, vmovn_u64(accumulator), prime));
+    }
+}
+#endif
+
+/** Retrieve the fastest XXH3 kernels the running CPU supports, checking the
+CPU only once. On AArch64 NEON is always present, so it needs no check. */
+const XXH3Kernels& xxh3_kernels() noexcept {
+#if defined(YATTA_XXH3_X86)
+    static const XXH3Kernels kernels =
+        cpu_has_avx2()
+            ? XXH3Kernels{ xxh3_accumulate_avx2, xxh3_scramble_avx2 }
+            : XXH3Kernels{ xxh3_accumulate_sse2, xxh3_scramble_sse2 };
+#elif defined(YATTA_XXH3_NEON)
+    static const XXH3Kernels kernels{ xxh3_accumulate_neon,
+                                      xxh3_scramble_neon };
+#else
+    static const XXH3Kernels kernels{ xxh3_accumulate_scalar,
+                                      xxh3_scramble_scalar };
+#endif
+    return kernels;
+}
+
+/** Accumulate a number of stripes, scrambling at the end of every block.
+@param  blockStripes    the number of stripes already in the current block. */
+void xxh3_consume_stripes(
+    std::uint64_t* const accumulators, size_t& blockStripes,
+    const std::byte* dataPtr, size_t stripeCount,
+    const XXH3Kernels& kernels) noexcept {
+    while (stripeCount > 0ULL) {
+        const auto count = std::min(BlockStripes - blockStripes, stripeCount);
+        kernels.accumulate(
+            accumulators, dataPtr, xxh3_secret(blockStripes * 8ULL), count);
+        dataPtr += count * StripeSize;
+        stripeCount -= count;
+        blockStripes += count;
+        if (blockStripes == BlockStripes) {
+            kernels.scramble(accumulators, xxh3_secret(ScrambleSecret));
+            blockStripes = 0ULL;
+        }
+    }
+}
+
+/** Accumulate the final stripe of the input, then merge the accumulators. */
+std::uint64_t xxh3_finish(
+    std::uint64_t* const accumulators, const std::byte* const lastStripePtr,
+    const std::uint64_t& size, const XXH3Kernels& kernels) noexcept {
+    kernels.accumulate(
+        accumulators, lastStripePtr, xxh3_secret(ScrambleSecret - 7ULL), 1ULL);
+    auto hash = size * Prime64_1;
+    for (size_t pair = 0ULL; pair < 4ULL; ++pair)
+        hash += mul128_fold64(
+            accumulators[pair * 2ULL] ^
+                read_value<std::uint64_t>(xxh3_secret(11ULL + (pair * 16ULL))),
+            accumulators[(pair * 2ULL) + 1ULL] ^
+                read_value<std::uint64_t>(xxh3_secret(19ULL + (pair * 16ULL))));
+    return xxh3_avalanche(hash);
+}
+
+/** Hash a range of memory in one pass with XXH3. */
+std::uint64_t
+xxh3(const std::byte* const dataPtr, const size_t& size) noexcept {
+    if (size <= MidSizeMax)
+        return xxh3_medium(dataPtr, size);
+
+    // Accumulate every stripe but the last, which may overlap the one before
+    const auto& kernels = xxh3_kernels();
+    alignas(64) std::uint64_t accumulators[8];
+    std::memcpy(accumulators, InitialAccumulators, sizeof(accumulators));
+    size_t blockStripes(0ULL);
+    xxh3_consume_stripes(
+        accumulators, blockStripes, dataPtr, (size - 1ULL) / StripeSize,
+        kernels);
+    return xxh3_finish(
+        accumulators, &dataPtr[size - StripeSize], size, kernels);
+}
+
+// Public (de)Constructors
+
+Hasher::Hasher(const HashVersion& version) noexcept : m_version(version) {}
+
+// Public Methods
+
+void Hasher::update(const MemoryRange& range) noexcept {
+    update(range.bytes(), range.size());
+}
+
+void Hasher::update(const void* const dataPtr, const size_t& size) noexcept {
+    if (dataPtr == nullptr || size == 0ULL)
+        return;
+    const auto* bytes = static_cast<const std::byte*>(dataPtr);
+    m_size += size;
+
+    if (m_version == HashVersion::Legacy) {
+        // Hash 8 bytes at a time, holding onto any incomplete word
+        for (size_t byteIndex = 0ULL; byteIndex < size;) {
+            const auto length =
+                std::min(sizeof(size_t) - m_legacyWordSize, size - byteIndex);
+            std::memcpy(
+                &m_legacyWord[m_legacyWordSize], &bytes[byteIndex], length);
+            m_legacyWordSize += length;
+            byteIndex += length;
+            if (m_legacyWordSize == sizeof(size_t)) {
+                m_legacyValue = ((m_legacyValue << 5ULL) + m_legacyValue) +
+                                read_value<size_t>(m_legacyWord);
+                m_legacyWordSize = 0ULL;
+            }
+        }
+        return;
+    }
+
+    // Hash each chunk separately, only moving a full chunk's digest into the
+    // tree once more data follows it
+    for (size_t byteIndex = 0ULL; byteIndex < size;) {
+        if (m_chunkState.m_size == TreeHashChunk) {
+            const auto digest = m_chunkState.digest();
+            m_treeState.update(
+                reinterpret_cast<const std::byte*>(&digest), sizeof(digest));
+            m_chunkState = XXH3State();
+        }
+        const auto length = std::min(
+            TreeHashChunk - static_cast<size_t>(m_chunkState.m_size),
+            size - byteIndex);
+        m_chunkState.update(&bytes[byteIndex], length);
+        byteIndex += length;
+    }
+}
+
+size_t Hasher::finalize() const noexcept {
+    if (m_version == HashVersion::Legacy) {
+        // Hash any remaining bytes
+        auto value = m_legacyValue;
+        const auto* const remainderPtr =
+            reinterpret_cast<const char*>(m_legacyWord);
+        for (size_t index = 0ULL; index < m_legacyWordSize; ++index)
+            value = ((value << 5ULL) + value) + remainderPtr[index];
+        return value;
+    }
+
+    // Small amounts of data are hashed directly
+    if (m_size <= TreeHashChunk)
+        return m_chunkState.digest();
+
+    // Otherwise finish the tree with the last chunk's digest and the size
+    auto treeState = m_treeState;
+    const std::uint64_t tail[2] = { m_chunkState.digest(), m_size };
+    treeState.update(reinterpret_cast<const std::byte*>(tail), sizeof(tail));
+    return treeState.digest();
+}
+
+void Hasher::reset() noexcept {
+    m_size = 0ULL;
+    m_chunkState = XXH3State();
+    m_treeState = XXH3State();
+    m_legacyValue = ZeroHash;
+    m_legacyWordSize = 0ULL;
+}
+
+// Public Static Methods
+
+size_t
+Hasher::Hash(const MemoryRange& range, const HashVersion& version) noexcept {
+    if (range.bytes() == nullptr)
+        return ZeroHash;
+    if (version == HashVersion::Legacy) {
+        Hasher hasher(version);
+        hasher.update(range);
+        return hasher.finalize();
+    }
+    const auto size = range.size();
+    if (size <= TreeHashChunk)
+        return xxh3(range.bytes(), size);
+
+    // Hash large ranges as a tree of fixed-size chunks, so that the result is
+    // the same regardless of how many threads hashed them. Digests are hashed
+    // in batches, streaming each batch into the tree's state.
+    const size_t chunkCount = (size + TreeHashChunk - 1ULL) / TreeHashChunk;
+    XXH3State treeState;
+    std::uint64_t digests[TreeHashBatch];
+    for (size_t batch = 0ULL; batch < chunkCount; batch += TreeHashBatch) {
+        const auto batchEnd = std::min(batch + TreeHashBatch, chunkCount);
+        const auto hash_chunk = [&](const size_t& chunk) noexcept {
+            const auto offset = chunk * TreeHashChunk;
+            digests[chunk - batch] = xxh3(
+                &range.bytes()[offset], std::min(TreeHashChunk, size - offset));
+        };
+        try {
+            Threader::GetShared().parallel_for(
+                batch, batchEnd, hash_chunk, 1ULL);
+        } catch (...) {
+            // Scheduling the jobs failed, so hash this batch on this thread
+            for (auto chunk = batch; chunk < batchEnd; ++chunk)
+                hash_chunk(chunk);
+        }
+        treeState.update(
+            reinterpret_cast<const std::byte*>(digests),
+            (batchEnd - batch) * sizeof(std::uint64_t));
+    }
+    const std::uint64_t rangeSize = size;
+    treeState.update(
+        reinterpret_cast<const std::byte*>(&rangeSize), sizeof(rangeSize));
+    return treeState.digest();
+}
+
+// XXH3State (de)Constructors
+
+Hasher::XXH3State::XXH3State() noexcept {
+    std::memcpy(m_accumulators, InitialAccumulators, sizeof(m_accumulators));
+}
+
+// XXH3State Methods
+
+void Hasher::XXH3State::update(
+    const std::byte* dataPtr, size_t size) noexcept {
+    m_size += size;
+
+    // Buffer data until there is more than the buffer holds, as the final
+    // stripe must be accumulated differently from the rest
+    if (size <= sizeof(m_buffer) - m_bufferSize) {
+        std::memcpy(&m_buffer[m_bufferSize], dataPtr, size);
+        m_bufferSize += size;
+        return;
+    }
+    const auto& kernels = xxh3_kernels();
+    constexpr auto BufferStripes = sizeof(m_buffer) / StripeSize;
+    if (m_bufferSize != 0ULL) {
+        const auto length = sizeof(m_buffer) - m_bufferSize;
+        std::memcpy(&m_buffer[m_bufferSize], dataPtr, length);
+        dataPtr += length;
+        size -= length;
+        xxh3_consume_stripes(
+            m_accumulators, m_blockStripes, m_buffer, BufferStripes, kernels);
+        m_bufferSize = 0ULL;
+    }
+
+    // Consume whole stripes directly, keeping the last one consumed at the
+    // end of the buffer in case the final stripe needs to overlap it
+    if (size > sizeof(m_buffer)) {
+        const auto stripeCount = (size - 1ULL) / StripeSize;
+        xxh3_consume_stripes(
+            m_accumulators, m_blockStripes, dataPtr, stripeCount, kernels);
+        dataPtr += stripeCount * StripeSize;
+        size -= stripeCount * StripeSize;
+        std::memcpy(
+            &m_buffer[sizeof(m_buffer) - StripeSize], dataPtr - StripeSize,
+            StripeSize);
+    }
+    std::memcpy(m_buffer, dataPtr, size);
+    m_bufferSize = size;
+}
+
+std::uint64_t Hasher::XXH3State::digest() const noexcept {
+    if (m_size <= MidSizeMax)
+        return xxh3_medium(m_buffer, static_cast<size_t>(m_size));
+
+    // Finish on copies, so that this state can keep hashing afterwards
+    const auto& kernels = xxh3_kernels();
+    alignas(64) std::uint64_t accumulators[8];
+    std::memcpy(accumulators, m_accumulators, sizeof(accumulators));
+    if (m_bufferSize >= StripeSize) {
+        auto blockStripes = m_blockStripes;
+        xxh3_consume_stripes(
+            accumulators, blockStripes, m_buffer,
+            (m_bufferSize - 1ULL) / StripeSize, kernels);
+        return xxh3_finish(
+            accumulators, &m_buffer[m_bufferSize - StripeSize], m_size,
+            kernels);
+    }
+
+    // The final stripe overlaps data consumed earlier, still at the end of
+    // the buffer
+    std::byte lastStripe[StripeSize];
+    const auto catchUp = StripeSize - m_bufferSize;
+    std::memcpy(lastStripe, &m_buffer[sizeof(m_buffer) - catchUp], catchUp);
+    std::memcpy(&lastStripe[catchUp], m_buffer, m_bufferSize);
+    return xxh3_finish(accumulators, lastStripe, m_size, kernels);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef YATTA_HASHER_H
+#define YATTA_HASHER_H
+
+#include "memoryRange.hpp"
+#include <cstdint>
+
+namespace yatta {
+/** Hashes data incrementally, as it arrives in pieces of any size.
+The result matches MemoryRange::hash() for a range holding the same contents,
+so data can be hashed while it is streamed rather than re-scanned afterwards. */
+class Hasher {
+    public:
+    // Public (de)Constructors
+    /** Construct a hasher with nothing hashed yet.
+    @param  version         the version of the hash algorithm to use. */
+    explicit Hasher(
+        const HashVersion& version = HashVersion::Current) noexcept;
+
+    // Public Methods
+    /** Hash the contents of a memory range, following any previous data.
+    @param  range           the memory range to hash. */
+    void update(const MemoryRange& range) noexcept;
+    /** Hash a range of raw memory, following any previous data.
+    @param  dataPtr         pointer to the data to hash.
+    @param  size            the number of bytes to hash. */
+    void update(const void* const dataPtr, const size_t& size) noexcept;
+    /** Retrieve the hash of all the data so far, leaving this hasher able to
+    continue hashing more.
+    @return                 hash value calculated for the data. */
+    size_t finalize() const noexcept;
+    /** Forget all the data hashed so far. */
+    void reset() noexcept;
+
+    // Public Static Methods
+    /** Hash the contents of a memory range in one pass, hashing large ranges
+    in parallel.
+    @param  range           the memory range to hash.
+    @param  version         the version of the hash algorithm to use.
+    @return                 hash value calculated for the range's memory,
+    ZeroHash if the range is null. */
+    static size_t Hash(
+        const MemoryRange& range,
+        const HashVersion& version = HashVersion::Current) noexcept;
+
+    private:
+    // Private Structures
+    /** Running state of a 64-bit XXH3 hash. */
+    struct XXH3State {
+        XXH3State() noexcept;
+        void update(const std::byte* dataPtr, size_t size) noexcept;
+        std::uint64_t digest() const noexcept;
+        std::uint64_t m_size = 0ULL;
+        alignas(64) std::uint64_t m_accumulators[8];
+        std::byte m_buffer[256] = {};
+        size_t m_bufferSize = 0ULL, m_blockStripes = 0ULL;
+    };
+
+    // Private Attributes
+    HashVersion m_version = HashVersion::Current;
+    size_t m_size = 0ULL;
+    XXH3State m_chunkState, m_treeState;
+    size_t m_legacyValue = ZeroHash, m_legacyWordSize = 0ULL;
+    std::byte m_legacyWord[8] = {};
+};
+}; // namespace yatta
+
+#endif // YATTA_HASHER_H
@@ -0,0 +1,133 @@
+#include "mappedFile.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+// Convenience Definitions
+using yatta::HashVersion;
+using yatta::MappedFile;
+using yatta::MemoryRange;
+
+// Public (de)Constructors
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+    const auto file = CreateFileW(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return; // Failure
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) == 0) {
+        CloseHandle(file);
+        return; // Failure
+    }
+
+    // Empty files can't be mapped, but are still valid
+    if (fileSize.QuadPart > 0) {
+        const auto mapping =
+            CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+            return; // Failure
+        const auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (view == nullptr)
+            return; // Failure
+        m_range = MemoryRange(
+            static_cast<size_t>(fileSize.QuadPart),
+            static_cast<std::byte*>(view));
+    } else
+        CloseHandle(file);
+#else
+    const auto file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return; // Failure
+    struct stat fileStat {};
+    if (::fstat(file, &fileStat) != 0) {
+        ::close(file);
+        return; // Failure
+    }
+
+    // Empty files can't be mapped, but are still valid
+    if (fileStat.st_size > 0) {
+        const auto size = static_cast<size_t>(fileStat.st_size);
+        auto* const view =
+            ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);
+        if (view == MAP_FAILED)
+            return; // Failure
+        m_range = MemoryRange(size, static_cast<std::byte*>(view));
+    } else
+        ::close(file);
+#endif // _WIN32
+    m_open = true;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_range(std::exchange(other.m_range, MemoryRange())),
+      m_open(std::exchange(other.m_open, false)) {}
+
+// Public Assignment Operators
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_range = std::exchange(other.m_range, MemoryRange());
+        m_open = std::exchange(other.m_open, false);
+    }
+    return *this;
+}
+
+// Public Conversion Operators
+
+MappedFile::operator const MemoryRange&() const noexcept { return m_range; }
+
+// Public Inquiry Methods
+
+bool MappedFile::isOpen() const noexcept { return m_open; }
+
+bool MappedFile::empty() const noexcept { return m_range.empty(); }
+
+bool MappedFile::hasData() const noexcept { return m_range.hasData(); }
+
+size_t MappedFile::size() const noexcept { return m_range.size(); }
+
+size_t MappedFile::hash(const HashVersion& version) const noexcept {
+    return m_range.hash(version);
+}
+
+const std::byte& MappedFile::operator[](const size_t& byteIndex) const {
+    return m_range[byteIndex];
+}
+
+const char* MappedFile::charArray() const noexcept {
+    return m_range.charArray();
+}
+
+const std::byte* MappedFile::bytes() const noexcept { return m_range.bytes(); }
+
+// Public Manipulation Methods
+
+void MappedFile::close() noexcept {
+    if (m_range.bytes() != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_range.bytes());
+#else
+        ::munmap(m_range.bytes(), m_range.size());
+#endif // _WIN32
+    }
+    m_range = MemoryRange();
+    m_open = false;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef YATTA_MAPPEDFILE_H
+#define YATTA_MAPPEDFILE_H
+
+#include "memoryRange.hpp"
+#include <filesystem>
+
+namespace yatta {
+/** A read-only memory range backed by a file mapped into memory.
+Pages are read from disk on demand as the range is accessed, rather than being
+copied onto the heap up front. The mapping is read-only, so only const access
+to it is exposed, and writing through its memory faults. */
+class MappedFile {
+    public:
+    // Public (de)Constructors
+    /** Destroy this mapped file, unmapping its memory. */
+    ~MappedFile();
+    /** Construct an empty mapped file. */
+    MappedFile() = default;
+    /** Construct a mapped file, mapping the file found at the path specified.
+    @param  path            the path to the file to map. */
+    explicit MappedFile(const std::filesystem::path& path);
+    /** Deleted copy-assignment constructor. */
+    MappedFile(const MappedFile&) = delete;
+    /** Construct a mapped file, moving from another.
+    @param  other           the mapped file to move from. */
+    MappedFile(MappedFile&& other) noexcept;
+
+    // Public Assignment Operators
+    /** Deleted copy-assignment operator. */
+    MappedFile& operator=(const MappedFile& other) = delete;
+    /** Move-assignment operator.
+    @param  other           the mapped file to move from.
+    @return                 reference to this. */
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Public Conversion Operators
+    /** Retrieve a read-only view of the mapped memory, so that it can be
+    hashed, compressed or diffed directly.
+    @return                 const reference to the mapped memory range. */
+    operator const MemoryRange&() const noexcept;
+
+    // Public Inquiry Methods
+    /** Check if a file was successfully mapped, which may still be empty.
+    @return                 true if open, false otherwise. */
+    bool isOpen() const noexcept;
+    /** Check if the mapped memory is empty.
+    @return                 true if the pointer is null or the size is zero. */
+    bool empty() const noexcept;
+    /** Retrieves whether or not the mapped memory's size is greater than zero.
+    @return                 true if non-zero range, false otherwise. */
+    bool hasData() const noexcept;
+    /** Returns the length of the mapped memory.
+    @return                 number of bytes mapped. */
+    size_t size() const noexcept;
+    /** Generates a hash value derived from the mapped memory's contents.
+    @param  version         the version of the hash algorithm to use.
+    @return                 hash value calculated for the mapped memory. */
+    size_t hash(const HashVersion& version = HashVersion::Current) const
+        noexcept;
+    /** Retrieves a const reference to the data at the byte index specified.
+    @note   will throw if accessed out of range.
+    @param  byteIndex       how many bytes into the mapping to index at.
+    @return                 reference to data found at the byte index. */
+    const std::byte& operator[](const size_t& byteIndex) const;
+    /** Retrieves a const character array pointer to the mapped memory.
+    @return                 data pointer cast to const char *. */
+    const char* charArray() const noexcept;
+    /** Retrieves a const raw pointer to the mapped memory.
+    @return                 pointer to the mapped memory. */
+    const std::byte* bytes() const noexcept;
+
+    // Public Manipulation Methods
+    /** Unmap the file, leaving this range empty. */
+    void close() noexcept;
+
+    private:
+    // Private Attributes
+    MemoryRange m_range;
+    bool m_open = false;
+};
+}; // namespace yatta
+
+#endif // YATTA_MAPPEDFILE_H
@@ -1,6 +1,9 @@
 #include "memoryRange.hpp"
+#include "hasher.hpp"
 
 // Convenience Definition
+using yatta::HashVersion;
+using yatta::Hasher;
 using yatta::MemoryRange;
 
 // Public Constructor
@@ -20,25 +23,8 @@ bool MemoryRange::hasData() const noexcept {
 
 size_t MemoryRange::size() const noexcept { return m_range; }
 
-size_t MemoryRange::hash() const noexcept {
-    if (m_dataPtr == nullptr)
-        return ZeroHash;
-
-    // Hash using 8 bytes at a time
-    size_t value(ZeroHash);
-    size_t index(0ULL);
-    const size_t max(m_range / 8ULL);
-    const auto* const ptr8Byte = reinterpret_cast<const size_t*>(m_dataPtr);
-    while (index < max)
-        value = ((value << 5ULL) + value) + ptr8Byte[index++];
-
-    // Hash any remaining bytes
-    const char* const remainderPtr = reinterpret_cast<const char*>(m_dataPtr);
-    index *= 8ULL;
-    while (index < m_range)
-        value = ((value << 5ULL) + value) + remainderPtr[index++];
-
-    return value;
+size_t MemoryRange::hash(const HashVersion& version) const noexcept {
+    return Hasher::Hash(*this, version);
 }
 
 // Public Manipulation Methods
@@ -55,11 +41,17 @@ const std::byte& MemoryRange::operator[](const size_t& byteIndex) const {
     return m_dataPtr[byteIndex];
 }
 
-char* MemoryRange::charArray() const noexcept {
+char* MemoryRange::charArray() noexcept {
     return reinterpret_cast<char*>(&m_dataPtr[0]);
 }
 
-std::byte* MemoryRange::bytes() const noexcept { return m_dataPtr; }
+const char* MemoryRange::charArray() const noexcept {
+    return reinterpret_cast<const char*>(&m_dataPtr[0]);
+}
+
+std::byte* MemoryRange::bytes() noexcept { return m_dataPtr; }
+
+const std::byte* MemoryRange::bytes() const noexcept { return m_dataPtr; }
 
 MemoryRange
 MemoryRange::subrange(const size_t& offset, const size_t& length) const {
@@ -10,6 +10,17 @@
 namespace yatta {
 constexpr size_t ZeroHash = 1234567890ULL;
 
+/** The versions of the hash algorithm, so stored hashes can be reproduced. */
+enum class HashVersion : size_t {
+    /** Multiplicative hash of 8-byte words, used by older deltas. */
+    Legacy = 1ULL,
+    /** 64-bit XXH3, SIMD-accelerated and tree-hashed in parallel over ranges
+    larger than 4 MB. */
+    XXH3 = 2ULL,
+    /** The version used unless otherwise specified. */
+    Current = XXH3
+};
+
 /** A range of contiguous memory.
 Provides means of indexing and manipulating the data it represents. */
 class MemoryRange {
@@ -50,8 +61,10 @@ class MemoryRange {
     @return                 number of bytes in this range. */
     size_t size() const noexcept;
     /** Generates a hash value derived from this range's contents.
+    @param  version         the version of the hash algorithm to use.
     @return                 hash value calculated for this range's memory. */
-    size_t hash() const noexcept;
+    virtual size_t hash(const HashVersion& version = HashVersion::Current) const
+        noexcept;
 
     // Public Manipulation Methods
     /** Retrieves a reference to the data at the byte index specified.
@@ -66,10 +79,16 @@ class MemoryRange {
     const std::byte& operator[](const size_t& byteIndex) const;
     /** Retrieves a character array pointer to this range's data.
     @return                 data pointer cast to char *. */
-    char* charArray() const noexcept;
+    char* charArray() noexcept;
+    /** Retrieves a const character array pointer to this range's data.
+    @return                 data pointer cast to const char *. */
+    const char* charArray() const noexcept;
     /** Retrieves a raw pointer to this range's data.
     @return                 pointer to this range's data. */
-    std::byte* bytes() const noexcept;
+    std::byte* bytes() noexcept;
+    /** Retrieves a const raw pointer to this range's data.
+    @return                 const pointer to this range's data. */
+    const std::byte* bytes() const noexcept;
     /** Generate a sub-range from this memory range.
     @note   will throw if accessed out of range.
     @param  offset          the byte index to begin the sub-range at.
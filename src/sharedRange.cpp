@@ -0,0 +1,116 @@
+#include "sharedRange.hpp"
+
+// Convenience Definitions
+using yatta::HashVersion;
+using yatta::MemoryRange;
+using yatta::SharedRange;
+
+// Public (de)Constructors
+
+SharedRange::SharedRange(const SharedRange& other) noexcept
+    : m_view(other.m_view), m_owner(other.m_owner) {}
+
+SharedRange::SharedRange(SharedRange&& other) noexcept
+    : m_view(std::exchange(other.m_view, CachedRange())),
+      m_owner(std::move(other.m_owner)) {}
+
+// Public Assignment Operators
+
+SharedRange& SharedRange::operator=(const SharedRange& other) noexcept {
+    if (this != &other) {
+        m_view = other.m_view;
+        m_owner = other.m_owner;
+    }
+    return *this;
+}
+
+SharedRange& SharedRange::operator=(SharedRange&& other) noexcept {
+    if (this != &other) {
+        m_view = std::exchange(other.m_view, CachedRange());
+        m_owner = std::move(other.m_owner);
+    }
+    return *this;
+}
+
+// Public Conversion Operators
+
+SharedRange::operator const MemoryRange&() const noexcept { return m_view; }
+
+// Public Inquiry Methods
+
+long SharedRange::useCount() const noexcept { return m_owner.use_count(); }
+
+bool SharedRange::empty() const noexcept { return m_view.empty(); }
+
+bool SharedRange::hasData() const noexcept { return m_view.hasData(); }
+
+size_t SharedRange::size() const noexcept { return m_view.size(); }
+
+size_t SharedRange::hash(const HashVersion& version) const noexcept {
+    return m_view.hash(version);
+}
+
+const std::byte& SharedRange::operator[](const size_t& byteIndex) const {
+    return m_view[byteIndex];
+}
+
+const char* SharedRange::charArray() const noexcept {
+    return m_view.charArray();
+}
+
+const std::byte* SharedRange::bytes() const noexcept { return m_view.bytes(); }
+
+// Public Manipulation Methods
+
+SharedRange
+SharedRange::slice(const size_t& offset, const size_t& length) const {
+    // Ensure data won't exceed range
+    auto range = m_view.subrange(offset, length);
+
+    // Share ownership of the same memory, without the parent's hash
+    SharedRange sharedRange;
+    sharedRange.m_view = CachedRange(range.size(), range.bytes());
+    sharedRange.m_owner = m_owner;
+    return sharedRange;
+}
+
+void SharedRange::reset() noexcept {
+    m_view = CachedRange();
+    m_owner.reset();
+}
+
+// CachedRange (de)Constructors
+
+SharedRange::CachedRange::CachedRange(const CachedRange& other) noexcept
+    : MemoryRange(other) {
+    *this = other;
+}
+
+// CachedRange Assignment Operators
+
+SharedRange::CachedRange&
+SharedRange::CachedRange::operator=(const CachedRange& other) noexcept {
+    MemoryRange::operator=(other);
+    const auto hashed = other.m_hashed.load(std::memory_order_acquire);
+    m_hash.store(
+        other.m_hash.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    m_hashed.store(hashed, std::memory_order_release);
+    return *this;
+}
+
+// CachedRange Inquiry Methods
+
+size_t SharedRange::CachedRange::hash(const HashVersion& version) const
+    noexcept {
+    if (version != HashVersion::Current)
+        return MemoryRange::hash(version);
+    if (m_hashed.load(std::memory_order_acquire))
+        return m_hash.load(std::memory_order_relaxed);
+
+    // Concurrent callers may both hash, but will store the same value
+    const auto value = MemoryRange::hash(version);
+    m_hash.store(value, std::memory_order_relaxed);
+    m_hashed.store(true, std::memory_order_release);
+    return value;
+}
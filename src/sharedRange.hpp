@@ -0,0 +1,130 @@
+#pragma once
+#ifndef YATTA_SHAREDRANGE_H
+#define YATTA_SHAREDRANGE_H
+
+#include "memoryRange.hpp"
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace yatta {
+/** A reference-counted range of memory, owned by another memory range.
+Copies and slices share ownership of the same memory rather than duplicating
+it, which is freed once the last of them is destroyed. As the memory is shared,
+only const access to it is exposed, and its hash is cached once generated. */
+class SharedRange {
+    public:
+    // Public (de)Constructors
+    /** Destroy this shared range, releasing its share of the memory. */
+    ~SharedRange() = default;
+    /** Construct an empty shared range. */
+    SharedRange() = default;
+    /** Construct a shared range, taking ownership of a memory range such as a
+    buffer or mapped file.
+    @tparam T               the owning range type (auto-deducible).
+    @param  owner           the range to take ownership of. */
+    template <
+        typename T,
+        typename = std::enable_if_t<
+            std::is_convertible_v<const std::decay_t<T>&, const MemoryRange&> &&
+            !std::is_same_v<std::decay_t<T>, SharedRange> &&
+            !std::is_lvalue_reference_v<T>>>
+    explicit SharedRange(T&& owner) {
+        auto sharedOwner = std::make_shared<std::decay_t<T>>(std::move(owner));
+        // The view is only ever exposed as const, so it may hold the owner's
+        // memory without write access being handed out
+        const MemoryRange& ownerRange = *sharedOwner;
+        m_view = CachedRange(
+            ownerRange.size(), const_cast<std::byte*>(ownerRange.bytes()));
+        m_owner = std::move(sharedOwner);
+    }
+    /** Construct a shared range, sharing ownership with another.
+    @param  other           the range to share with. */
+    SharedRange(const SharedRange& other) noexcept;
+    /** Construct a shared range, moving from another.
+    @param  other           the range to move from. */
+    SharedRange(SharedRange&& other) noexcept;
+
+    // Public Assignment Operators
+    /** Copy-assignment operator, sharing ownership with another.
+    @param  other           the range to share with.
+    @return                 reference to this. */
+    SharedRange& operator=(const SharedRange& other) noexcept;
+    /** Move-assignment operator.
+    @param  other           the range to move from.
+    @return                 reference to this. */
+    SharedRange& operator=(SharedRange&& other) noexcept;
+
+    // Public Conversion Operators
+    /** Retrieve a read-only view of the shared memory, which hashes through
+    this range's cache.
+    @return                 const reference to the shared memory range. */
+    operator const MemoryRange&() const noexcept;
+
+    // Public Inquiry Methods
+    /** Retrieve the number of shared ranges sharing this range's memory.
+    @return                 the number of owners, 0 if empty. */
+    long useCount() const noexcept;
+    /** Check if the shared memory is empty.
+    @return                 true if the pointer is null or the size is zero. */
+    bool empty() const noexcept;
+    /** Retrieves whether or not the shared memory's size is greater than zero.
+    @return                 true if non-zero range, false otherwise. */
+    bool hasData() const noexcept;
+    /** Returns the length of the shared memory.
+    @return                 number of bytes in this range. */
+    size_t size() const noexcept;
+    /** Generates a hash value derived from this range's contents, caching it
+    for subsequent calls.
+    @param  version         the version of the hash algorithm to use, only the
+    current version being cached.
+    @return                 hash value calculated for this range's memory. */
+    size_t hash(const HashVersion& version = HashVersion::Current) const
+        noexcept;
+    /** Retrieves a const reference to the data at the byte index specified.
+    @note   will throw if accessed out of range.
+    @param  byteIndex       how many bytes into this range to index at.
+    @return                 reference to data found at the byte index. */
+    const std::byte& operator[](const size_t& byteIndex) const;
+    /** Retrieves a const character array pointer to this range's data.
+    @return                 data pointer cast to const char *. */
+    const char* charArray() const noexcept;
+    /** Retrieves a const raw pointer to this range's data.
+    @return                 pointer to this range's data. */
+    const std::byte* bytes() const noexcept;
+
+    // Public Manipulation Methods
+    /** Generate a sub-range from this range, sharing ownership of its memory.
+    @note   will throw if accessed out of range.
+    @param  offset          the byte index to begin the sub-range at.
+    @param  length          the byte length of the sub-range.
+    @return                 the shared sub-range. */
+    SharedRange slice(const size_t& offset, const size_t& length) const;
+    /** Release this range's share of the memory, leaving it empty. */
+    void reset() noexcept;
+
+    private:
+    // Private Structures
+    /** A memory range caching its hash, only ever exposed as const. */
+    class CachedRange : public MemoryRange {
+        public:
+        using MemoryRange::MemoryRange;
+        CachedRange() = default;
+        CachedRange(const CachedRange& other) noexcept;
+        CachedRange& operator=(const CachedRange& other) noexcept;
+        size_t hash(const HashVersion& version = HashVersion::Current) const
+            noexcept final;
+
+        private:
+        mutable std::atomic_bool m_hashed = false;
+        mutable std::atomic_size_t m_hash = 0ULL;
+    };
+
+    // Private Attributes
+    CachedRange m_view;
+    std::shared_ptr<const void> m_owner;
+};
+}; // namespace yatta
+
+#endif // YATTA_SHAREDRANGE_H
@@ -1,8 +1,129 @@
 #include "threader.hpp"
+#include <chrono>
+#include <utility>
 
 // Convenience Definitions
+using yatta::TaskGroup;
 using yatta::Threader;
 
+/** Guards the creation of the shared threader. */
+std::mutex g_sharedMutex;
+/** The threader shared by all yatta operations, created on first use. */
+std::unique_ptr<Threader> g_sharedThreader;
+/** The number of threads the shared threader is created with. */
+size_t g_sharedThreadCount = std::thread::hardware_concurrency();
+/** The threader owning the current thread, if it is a worker. */
+thread_local const Threader* t_owner = nullptr;
+/** The index of the current worker's deque within its owning threader. */
+thread_local size_t t_workerIndex = 0ULL;
+
+/** Lock-free work-stealing deque, after Chase & Lev.
+Only the owning worker may push and pop from the bottom, whereas any thread may
+steal from the top. Grown arrays are retired rather than freed, as thieves may
+still be reading them. */
+class Threader::WorkDeque {
+    public:
+    // Public (de)constructors
+    ~WorkDeque() {
+        while (const auto job = pop())
+            delete job;
+    }
+    WorkDeque() : m_array(new Array(64)) { m_arrays.emplace_back(m_array); }
+    WorkDeque(const WorkDeque&) = delete;
+    WorkDeque(WorkDeque&&) = delete;
+    WorkDeque& operator=(const WorkDeque&) = delete;
+    WorkDeque& operator=(WorkDeque&&) = delete;
+
+    // Public Methods
+    /** Push a job onto the bottom, only callable by the owner. */
+    void push(const Job& job) {
+        const auto bottom = m_bottom.load(std::memory_order_relaxed);
+        const auto top = m_top.load(std::memory_order_acquire);
+        auto* array = m_array.load(std::memory_order_relaxed);
+        if (bottom - top > array->m_capacity - 1)
+            array = grow(array, top, bottom);
+        array->put(bottom, job);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    /** Pop a job from the bottom, only callable by the owner. */
+    Job pop() {
+        const auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        auto* array = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = m_top.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            // Deque was empty
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        auto job = array->get(bottom);
+        if (top == bottom) {
+            // Last job, race any thieves for it
+            if (!m_top.compare_exchange_strong(
+                    top, top + 1, std::memory_order_seq_cst,
+                    std::memory_order_relaxed))
+                job = nullptr;
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+    /** Steal a job from the top, callable by any thread. */
+    Job steal() {
+        auto top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return nullptr;
+        const auto* array = m_array.load(std::memory_order_acquire);
+        const auto job = array->get(top);
+        if (!m_top.compare_exchange_strong(
+                top, top + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+
+    private:
+    // Private Structures
+    /** Circular array of job slots. */
+    struct Array {
+        explicit Array(const std::ptrdiff_t& capacity)
+            : m_capacity(capacity),
+              m_slots(std::make_unique<std::atomic<Job>[]>(
+                  static_cast<size_t>(capacity))) {}
+        Job get(const std::ptrdiff_t& index) const noexcept {
+            return m_slots[static_cast<size_t>(index & (m_capacity - 1))].load(
+                std::memory_order_relaxed);
+        }
+        void put(const std::ptrdiff_t& index, const Job& job) noexcept {
+            m_slots[static_cast<size_t>(index & (m_capacity - 1))].store(
+                job, std::memory_order_relaxed);
+        }
+        std::ptrdiff_t m_capacity = 0;
+        std::unique_ptr<std::atomic<Job>[]> m_slots;
+    };
+
+    // Private Methods
+    /** Double the capacity of the array, copying over the live jobs. */
+    Array* grow(
+        const Array* const array, const std::ptrdiff_t& top,
+        const std::ptrdiff_t& bottom) {
+        auto* newArray = new Array(array->m_capacity * 2);
+        m_arrays.emplace_back(newArray);
+        for (auto index = top; index < bottom; ++index)
+            newArray->put(index, array->get(index));
+        m_array.store(newArray, std::memory_order_release);
+        return newArray;
+    }
+
+    // Private Attributes
+    std::atomic<std::ptrdiff_t> m_top = 0, m_bottom = 0;
+    std::atomic<Array*> m_array;
+    std::vector<std::unique_ptr<Array>> m_arrays;
+};
+
 // Public (de)constructors
 
 Threader::~Threader() { shutdown(); }
@@ -11,24 +132,27 @@ Threader::Threader(const size_t& maxThreads) {
     m_maxThreads = std::clamp<size_t>(
         maxThreads, 1ULL,
         static_cast<size_t>(std::thread::hardware_concurrency()));
+    m_queues.resize(m_maxThreads);
+    for (auto& queue : m_queues)
+        queue = std::make_unique<WorkDeque>();
     m_threads.resize(m_maxThreads);
-    for (auto& thread : m_threads) {
-        thread = std::thread([&]() {
+    for (size_t index = 0ULL; index < m_maxThreads; ++index) {
+        m_threads[index] = std::thread([&, index]() {
+            t_owner = this;
+            t_workerIndex = index;
             while (m_alive) {
-                // Check if there is a job to do
-                if (std::unique_lock<std::shared_mutex> guard(
-                        m_mutex, std::try_to_lock);
-                    guard.owns_lock() && !m_jobs.empty()) {
-                    // Get the first job, remove it from the list
-                    auto job = m_jobs.front();
-                    m_jobs.pop_front();
-                    // Unlock
-                    guard.unlock();
-                    guard.release();
-                    // Do Job
-                    job();
-                    m_jobsFinished++;
+                // Run any job we can find
+                if (const auto job = findJob(index)) {
+                    runJob(job);
+                    continue;
                 }
+
+                // Sleep until there is a job to do, or we're shutting down
+                std::unique_lock<std::mutex> guard(m_mutex);
+                m_sleepingThreads++;
+                m_jobCondition.wait(
+                    guard, [&]() { return !m_alive || m_pendingJobs > 0; });
+                m_sleepingThreads--;
             }
         });
     }
@@ -37,19 +161,181 @@ Threader::Threader(const size_t& maxThreads) {
 // Public Methods
 
 void Threader::addJob(const std::function<void()>&& func) {
-    std::unique_lock<std::shared_mutex> writeGuard(m_mutex);
-    m_jobs.emplace_back(func);
     m_jobsStarted++;
+    const auto job = new std::function<void()>(func);
+
+    // Jobs added from our own workers stay local, others are injected
+    if (t_owner == this)
+        m_queues[t_workerIndex]->push(job);
+    else {
+        std::unique_lock<std::mutex> injectorGuard(m_injectorMutex);
+        m_injector.emplace_back(job);
+    }
+
+    // Wake a sleeping worker
+    m_pendingJobs++;
+    if (m_sleepingThreads > 0ULL) {
+        std::unique_lock<std::mutex> guard(m_mutex);
+        m_jobCondition.notify_one();
+    }
 }
 
 bool Threader::isFinished() const noexcept {
     return m_jobsStarted == m_jobsFinished;
 }
 
+void Threader::wait() {
+    std::unique_lock<std::mutex> guard(m_mutex);
+    m_finishCondition.wait(guard, [&]() {
+        return !m_alive || m_jobsStarted == m_jobsFinished;
+    });
+}
+
 void Threader::shutdown() {
-    m_alive = false;
+    {
+        std::unique_lock<std::mutex> guard(m_mutex);
+        m_alive = false;
+    }
+    m_jobCondition.notify_all();
+    m_finishCondition.notify_all();
     for (auto& thread : m_threads)
         if (thread.joinable())
             thread.join();
     m_threads.clear();
-}
\ No newline at end of file
+
+    // Free any jobs left unfinished
+    m_queues.clear();
+    for (const auto& job : m_injector)
+        delete job;
+    m_injector.clear();
+}
+
+// Public Static Methods
+
+Threader& Threader::GetShared() {
+    std::unique_lock<std::mutex> guard(g_sharedMutex);
+    if (g_sharedThreader == nullptr)
+        g_sharedThreader = std::make_unique<Threader>(g_sharedThreadCount);
+    return *g_sharedThreader;
+}
+
+void Threader::SetSharedThreadCount(const size_t& maxThreads) {
+    std::unique_lock<std::mutex> guard(g_sharedMutex);
+    g_sharedThreadCount = maxThreads;
+    g_sharedThreader.reset();
+}
+
+// Private Methods
+
+bool Threader::isWorker() const noexcept { return t_owner == this; }
+
+bool Threader::runPendingJob() {
+    if (!isWorker())
+        return false;
+    if (const auto job = findJob(t_workerIndex)) {
+        runJob(job);
+        return true;
+    }
+    return false;
+}
+
+size_t
+Threader::chunkSize(const size_t& count, const size_t& grainSize) const
+    noexcept {
+    if (grainSize != 0ULL)
+        return grainSize;
+    // Aim for a few chunks per thread, so stealing can balance the load
+    return std::max<size_t>(1ULL, count / (m_maxThreads * 4ULL));
+}
+
+Threader::Job Threader::findJob(const size_t& workerIndex) {
+    // Check our own deque first
+    if (const auto job = m_queues[workerIndex]->pop())
+        return job;
+
+    // Check for jobs added from outside of the threader
+    {
+        std::unique_lock<std::mutex> injectorGuard(m_injectorMutex);
+        if (!m_injector.empty()) {
+            const auto job = m_injector.front();
+            m_injector.pop_front();
+            return job;
+        }
+    }
+
+    // Steal from the other workers
+    for (size_t offset = 1ULL; offset < m_maxThreads; ++offset)
+        if (const auto job =
+                m_queues[(workerIndex + offset) % m_maxThreads]->steal())
+            return job;
+    return nullptr;
+}
+
+void Threader::runJob(const Job& job) {
+    m_pendingJobs--;
+    (*job)();
+    delete job;
+
+    // Wake any waiting threads once the queue drains
+    if (++m_jobsFinished == m_jobsStarted) {
+        std::unique_lock<std::mutex> guard(m_mutex);
+        m_finishCondition.notify_all();
+    }
+}
+
+// TaskGroup (de)constructors
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // Exceptions were left unobserved, nothing left to report them to
+    }
+}
+
+TaskGroup::TaskGroup(Threader& threader) : m_threader(threader) {}
+
+// TaskGroup Public Methods
+
+void TaskGroup::run(std::function<void()>&& func) {
+    {
+        std::unique_lock<std::mutex> guard(m_mutex);
+        m_pendingJobs++;
+    }
+    m_threader.addJob([this, func = std::move(func)]() {
+        std::exception_ptr exception = nullptr;
+        try {
+            func();
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        // Only the first exception is kept
+        std::unique_lock<std::mutex> guard(m_mutex);
+        if (exception != nullptr && m_exception == nullptr)
+            m_exception = exception;
+        if (--m_pendingJobs == 0ULL)
+            m_condition.notify_all();
+    });
+}
+
+void TaskGroup::wait() {
+    std::unique_lock<std::mutex> guard(m_mutex);
+    const auto isFinished = [&]() noexcept { return m_pendingJobs == 0ULL; };
+    if (m_threader.isWorker()) {
+        // Keep this worker busy with other jobs rather than blocking it
+        while (!isFinished()) {
+            guard.unlock();
+            const auto ranJob = m_threader.runPendingJob();
+            guard.lock();
+            if (!ranJob)
+                m_condition.wait_for(
+                    guard, std::chrono::milliseconds(1), isFinished);
+        }
+    } else
+        m_condition.wait(guard, isFinished);
+
+    // Report any failures
+    if (m_exception != nullptr)
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+}
@@ -4,14 +4,23 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <deque>
+#include <exception>
 #include <functional>
-#include <shared_mutex>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace yatta {
-/** Utility class for executing tasks across multiple threads. */
+class TaskGroup;
+
+/** Utility class for executing tasks across multiple threads.
+Each worker owns a lock-free deque of jobs, stealing from the others when it
+runs dry. Jobs added from within a job go to the current worker's deque. */
 class Threader {
     public:
     // Public (de)constructors
@@ -40,18 +49,199 @@ class Threader {
     /** Check if the threader has completed all its jobs.
     @return                 true if finished, false otherwise. */
     bool isFinished() const noexcept;
+    /** Adds the specified function object to the queue, returning a future
+    for its result.
+    @tparam Func            the function type (auto-deducible).
+    @param  func            the task to be executed on a separate thread.
+    @return                 future holding the task's result or exception. */
+    template <typename Func>
+    std::future<std::invoke_result_t<std::decay_t<Func>>> submit(Func&& func);
+    /** Invoke a function on every index in a range, splitting the range into
+    chunks executed in parallel, and wait for them to finish.
+    @tparam Func            the function type (auto-deducible).
+    @param  begin           the first index of the range.
+    @param  end             one past the last index of the range.
+    @param  func            the function to invoke with each index.
+    @param  grainSize       the number of indices per chunk, 0 to derive one
+    from the thread count. */
+    template <typename Func>
+    void parallel_for(
+        const size_t& begin, const size_t& end, const Func& func,
+        const size_t& grainSize = 0ULL);
+    /** Map every index in a range to a value and combine the values, splitting
+    the range into chunks executed in parallel. Chunks are combined in index
+    order, so the result is deterministic for any thread count.
+    @tparam T               the value type (auto-deducible).
+    @tparam Map             the map function type (auto-deducible).
+    @tparam Reduce          the reduce function type (auto-deducible).
+    @param  begin           the first index of the range.
+    @param  end             one past the last index of the range.
+    @param  identity        the value to start each chunk's reduction with.
+    @param  map             the function converting an index into a value.
+    @param  reduce          the function combining 2 values into 1.
+    @param  grainSize       the number of indices per chunk, 0 to derive one
+    from the thread count.
+    @return                 the combined value of the entire range. */
+    template <typename T, typename Map, typename Reduce>
+    T parallel_reduce(
+        const size_t& begin, const size_t& end, const T& identity,
+        const Map& map, const Reduce& reduce, const size_t& grainSize = 0ULL);
+    /** Block the calling thread until all queued jobs have finished.
+    @note   waits on every job, use a TaskGroup to wait on a subset. */
+    void wait();
     /** Shuts down the threader, forcing threads to close. */
     void shutdown();
 
+    // Public Static Methods
+    /** Retrieve the threader shared by all yatta operations, creating it on
+    first use.
+    @return                 reference to the shared threader. */
+    static Threader& GetShared();
+    /** Set the number of threads the shared threader may use, replacing the
+    current shared threader if it exists.
+    @note   must not be called while other threads are using the shared
+    threader.
+    @param  maxThreads      the number of threads to spawn (max
+    std::thread::hardware_concurrency). */
+    static void SetSharedThreadCount(const size_t& maxThreads);
+
     private:
+    // Private Types
+    class WorkDeque;
+    using Job = std::function<void()>*;
+    friend class TaskGroup;
+
+    // Private Methods
+    /** Check if the calling thread is one of this threader's workers.
+    @return                 true if called from a worker, false otherwise. */
+    bool isWorker() const noexcept;
+    /** Run a single queued job on the calling worker thread.
+    @return                 true if a job was run, false otherwise. */
+    bool runPendingJob();
+    /** Derive how many indices to process per parallel chunk.
+    @param  count           the number of indices to process.
+    @param  grainSize       the requested chunk size, 0 to derive one.
+    @return                 the number of indices per chunk. */
+    size_t chunkSize(const size_t& count, const size_t& grainSize) const
+        noexcept;
+    /** Find a job for the specified worker, stealing if necessary.
+    @param  workerIndex     the index of the worker looking for a job.
+    @return                 a job on success, nullptr otherwise. */
+    Job findJob(const size_t& workerIndex);
+    /** Execute a job and record its completion.
+    @param  job             the job to execute, deleted afterwards. */
+    void runJob(const Job& job);
+
     // Private Attributes
-    std::shared_mutex m_mutex;
+    std::mutex m_mutex, m_injectorMutex;
+    std::condition_variable m_jobCondition, m_finishCondition;
     std::atomic_bool m_alive = true;
     std::vector<std::thread> m_threads;
-    std::deque<std::function<void()>> m_jobs;
-    std::atomic_size_t m_jobsStarted = 0ULL, m_jobsFinished = 0ULL;
+    std::vector<std::unique_ptr<WorkDeque>> m_queues;
+    std::deque<Job> m_injector;
+    std::atomic_size_t m_jobsStarted = 0ULL, m_jobsFinished = 0ULL,
+                       m_sleepingThreads = 0ULL;
+    std::atomic<std::ptrdiff_t> m_pendingJobs = 0;
     size_t m_maxThreads = 0ULL;
 };
+
+/** A set of jobs that can be waited on together, apart from any other jobs in
+its threader. Waiting from within a job runs other queued jobs meanwhile, so
+task groups can be nested without starving the threader. */
+class TaskGroup {
+    public:
+    // Public (de)constructors
+    /** Waits for any remaining jobs, then destroys this task group. */
+    ~TaskGroup();
+    /** Creates a task group that runs its jobs on the specified threader.
+    @param  threader        the threader to run jobs on. */
+    explicit TaskGroup(Threader& threader = Threader::GetShared());
+    /** Deleted copy-assignment constructor. */
+    TaskGroup(const TaskGroup&) = delete;
+    /** Deleted move-assignment constructor. */
+    TaskGroup(TaskGroup&&) = delete;
+
+    // Public Assignment Operators
+    /** Deleted copy-assignment operator. */
+    TaskGroup& operator=(const TaskGroup& other) = delete;
+    /** Deleted move-assignment operator. */
+    TaskGroup& operator=(TaskGroup&& other) = delete;
+
+    // Public Methods
+    /** Adds the specified function object to this group.
+    @param  func            the task to be executed on a separate thread. */
+    void run(std::function<void()>&& func);
+    /** Block the calling thread until all of this group's jobs have finished.
+    @note   rethrows the first exception thrown by any of the group's jobs. */
+    void wait();
+
+    private:
+    // Private Attributes
+    Threader& m_threader;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    size_t m_pendingJobs = 0ULL;
+    std::exception_ptr m_exception = nullptr;
+};
+
+// Template Definitions
+
+template <typename Func>
+std::future<std::invoke_result_t<std::decay_t<Func>>>
+Threader::submit(Func&& func) {
+    using Result = std::invoke_result_t<std::decay_t<Func>>;
+    auto task =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+    auto future = task->get_future();
+    addJob([task]() { (*task)(); });
+    return future;
+}
+
+template <typename Func>
+void Threader::parallel_for(
+    const size_t& begin, const size_t& end, const Func& func,
+    const size_t& grainSize) {
+    if (begin >= end)
+        return;
+    const auto chunk = chunkSize(end - begin, grainSize);
+    TaskGroup group(*this);
+    for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += chunk) {
+        const auto chunkEnd = std::min(chunkBegin + chunk, end);
+        group.run([&func, chunkBegin, chunkEnd]() {
+            for (auto index = chunkBegin; index < chunkEnd; ++index)
+                func(index);
+        });
+    }
+    group.wait();
+}
+
+template <typename T, typename Map, typename Reduce>
+T Threader::parallel_reduce(
+    const size_t& begin, const size_t& end, const T& identity,
+    const Map& map, const Reduce& reduce, const size_t& grainSize) {
+    if (begin >= end)
+        return identity;
+
+    // Reduce each chunk separately, into its own slot
+    const auto chunk = chunkSize(end - begin, grainSize);
+    std::vector<T> partials((end - begin + chunk - 1ULL) / chunk, identity);
+    TaskGroup group(*this);
+    for (size_t slot = 0ULL; slot < partials.size(); ++slot) {
+        group.run([&, slot]() {
+            const auto chunkBegin = begin + (slot * chunk);
+            const auto chunkEnd = std::min(chunkBegin + chunk, end);
+            for (auto index = chunkBegin; index < chunkEnd; ++index)
+                partials[slot] = reduce(partials[slot], map(index));
+        });
+    }
+    group.wait();
+
+    // Combine the chunks in order
+    auto result = identity;
+    for (const auto& partial : partials)
+        result = reduce(result, partial);
+    return result;
+}
 }; // namespace yatta
 
-#endif // YATTA_THREADER_H
\ No newline at end of file
+#endif // YATTA_THREADER_H
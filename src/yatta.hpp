@@ -2,9 +2,14 @@
 #ifndef YATTA_H
 #define YATTA_H
 
+#include "binaryIO.hpp"
 #include "buffer.hpp"
+#include "compressionStream.hpp"
 #include "directory.hpp"
+#include "hasher.hpp"
+#include "mappedFile.hpp"
 #include "memoryRange.hpp"
+#include "sharedRange.hpp"
 #include "threader.hpp"
 
 /** This namespace encompasses all yatta classes and methods. */
@@ -0,0 +1,95 @@
+#include "yatta.hpp"
+#include <cassert>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::BinaryReader;
+using yatta::BinaryWriter;
+using yatta::Buffer;
+using yatta::MemoryRange;
+
+// Forward Declarations
+void BinaryIO_RoundTripTest();
+void BinaryIO_BoundsTest();
+void BinaryIO_FormatTest();
+
+int main() {
+    BinaryIO_RoundTripTest();
+    BinaryIO_BoundsTest();
+    BinaryIO_FormatTest();
+    exit(0);
+}
+
+void BinaryIO_RoundTripTest() {
+    // Write a few records out
+    Buffer buffer;
+    BinaryWriter writer(buffer);
+    writer.write('U', 123ULL, 456ULL);
+    writer.write_string("some/path.txt");
+    writer.write_raw("payload", 7ULL);
+    assert(
+        buffer.size() == sizeof(char) + (sizeof(size_t) * 4ULL) + 13ULL + 7ULL);
+
+    // Ensure the same records can be read back in
+    BinaryReader reader(buffer);
+    [[maybe_unused]] char flag(0);
+    [[maybe_unused]] size_t oldHash(0ULL);
+    [[maybe_unused]] size_t newHash(0ULL);
+    std::string_view path;
+    MemoryRange payload;
+    assert(reader.read(flag, oldHash, newHash));
+    assert(flag == 'U' && oldHash == 123ULL && newHash == 456ULL);
+    assert(reader.read_string(path) && path == "some/path.txt");
+    assert(reader.read_range(7ULL, payload) && payload.size() == 7ULL);
+    assert(std::memcmp(payload.bytes(), "payload", 7ULL) == 0);
+    assert(reader.remaining() == 0ULL && reader.position() == buffer.size());
+
+    // Ensure strings view the range rather than copying it
+    assert(
+        reinterpret_cast<const std::byte*>(path.data()) ==
+        &buffer.bytes()[sizeof(char) + (sizeof(size_t) * 3ULL)]);
+}
+
+void BinaryIO_BoundsTest() {
+    // Ensure reading past the end fails without moving the cursor
+    Buffer buffer;
+    BinaryWriter writer(buffer);
+    writer.write(1ULL, 2ULL);
+    BinaryReader reader(buffer);
+    [[maybe_unused]] size_t a(0ULL);
+    [[maybe_unused]] size_t b(0ULL);
+    [[maybe_unused]] size_t c(0ULL);
+    assert(!reader.read(a, b, c) && reader.position() == 0ULL);
+    assert(reader.read(a, b) && a == 1ULL && b == 2ULL);
+    assert(!reader.read(c) && !reader.skip(1ULL));
+
+    // Ensure strings claiming more characters than remain fail
+    Buffer badString;
+    BinaryWriter(badString).write(1000ULL);
+    BinaryReader stringReader(badString);
+    std::string_view view;
+    assert(!stringReader.read_string(view) && stringReader.position() == 0ULL);
+
+    // Ensure strings missing their trailing size fail
+    Buffer truncated;
+    BinaryWriter(truncated).write_string("abc");
+    truncated.resize(truncated.size() - 1ULL);
+    BinaryReader truncatedReader(truncated);
+    assert(!truncatedReader.read_string(view));
+
+    // Ensure empty ranges can be read from safely
+    BinaryReader emptyReader{ MemoryRange() };
+    assert(!emptyReader.read(a) && emptyReader.remaining() == 0ULL);
+}
+
+void BinaryIO_FormatTest() {
+    // Ensure strings match the format buffers push
+    const std::string string("hello world");
+    Buffer pushed;
+    pushed.push_type(string);
+    Buffer written;
+    BinaryWriter(written).write_string(string);
+    assert(
+        pushed.size() == written.size() &&
+        std::memcmp(pushed.bytes(), written.bytes(), pushed.size()) == 0);
+}
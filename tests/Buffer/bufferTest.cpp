@@ -1,9 +1,13 @@
+#include "lz4/lz4.h"
 #include "yatta.hpp"
 #include <cassert>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
 
 // Convenience Definitions
 using yatta::Buffer;
+using yatta::MemoryRange;
 
 // Forward Declarations
 void Buffer_ConstructionTest();
@@ -11,7 +15,16 @@ void Buffer_AssignmentTest();
 void Buffer_MethodTest();
 void Buffer_IOTest();
 void Buffer_CompressionTest();
+void Buffer_BlockCompressionTest();
+void Buffer_HighCompressionTest();
 void Buffer_DiffTest();
+void Buffer_ShiftedDiffTest();
+void Buffer_SuffixDiffTest();
+void Buffer_ApproximateDiffTest();
+void Buffer_LargePatchTest();
+void Buffer_LegacyPatchTest();
+void Buffer_StreamingPatchTest();
+void Buffer_ResourceTest();
 
 // The structure we'll compress, decompress, diff, and patch
 struct TestStructureA {
@@ -33,13 +46,41 @@ struct TestStructureB {
     }
 };
 
+// A memory resource counting the allocations made through it
+class CountingResource : public std::pmr::memory_resource {
+    public:
+    size_t m_allocations = 0ULL;
+
+    private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++m_allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const
+        noexcept override {
+        return this == &other;
+    }
+};
+
 int main() {
     Buffer_ConstructionTest();
     Buffer_AssignmentTest();
     Buffer_MethodTest();
     Buffer_IOTest();
     Buffer_CompressionTest();
+    Buffer_BlockCompressionTest();
+    Buffer_HighCompressionTest();
     Buffer_DiffTest();
+    Buffer_ShiftedDiffTest();
+    Buffer_SuffixDiffTest();
+    Buffer_ApproximateDiffTest();
+    Buffer_LargePatchTest();
+    Buffer_LegacyPatchTest();
+    Buffer_StreamingPatchTest();
+    Buffer_ResourceTest();
     exit(0);
 }
 
@@ -52,6 +93,16 @@ void Buffer_ConstructionTest() {
     Buffer largeBuffer(1234ULL);
     assert(largeBuffer.hasData() && !largeBuffer.empty());
 
+    // Ensure we can construct exactly-sized buffers
+    Buffer zeroedBuffer(1234ULL, Buffer::Init::Zeroed);
+    assert(
+        zeroedBuffer.size() == 1234ULL && zeroedBuffer.capacity() == 1234ULL &&
+        zeroedBuffer[1233] == std::byte{ 0 });
+    Buffer uninitializedBuffer(1234ULL, Buffer::Init::Uninitialized);
+    assert(
+        uninitializedBuffer.size() == 1234ULL &&
+        uninitializedBuffer.capacity() == 1234ULL);
+
     // Ensure move constructor works
     Buffer moveBuffer(Buffer(1234ULL));
     assert(moveBuffer.size() == 1234ULL);
@@ -96,6 +147,12 @@ void Buffer_MethodTest() {
     buffer.reserve(3000ULL);
     assert(buffer.capacity() == 3000ULL);
 
+    // Ensure bytes added by resizing are zeroed
+    buffer[0] = std::byte{ 1 };
+    buffer.resize(1ULL);
+    buffer.resize(1234ULL);
+    assert(buffer[0] == std::byte{ 1 } && buffer[1233] == std::byte{ 0 });
+
     // Ensure we can shrink the buffer
     buffer.shrink();
     assert(buffer.size() == 1234ULL && buffer.capacity() == 1234ULL);
@@ -148,7 +205,7 @@ void Buffer_CompressionTest() {
     // Ensure we cannot compress or decompress an empty or incorrect buffer
     Buffer buffer;
     const auto badResult1 = buffer.compress();
-    const auto badResult2 = badResult1->decompress();
+    const auto badResult2 = buffer.decompress();
     assert(!badResult1 && !badResult2);
     // Create a buffer and load it with test data
     buffer.resize(sizeof(TestStructureA));
@@ -179,6 +236,155 @@ void Buffer_CompressionTest() {
         decompressedBuffer->hash() == buffer.hash());
 }
 
+void Buffer_BlockCompressionTest() {
+    // Fill a buffer spanning several compression blocks, with a few repeating
+    // phrases in random order
+    Buffer buffer(3670016ULL);
+    unsigned int seed(24680U);
+    for (size_t x = 0ULL; x < buffer.size(); ++x) {
+        if (x % 64ULL == 0ULL)
+            seed = (seed * 1103515245U) + 12345U;
+        buffer[x] =
+            static_cast<std::byte>((((seed >> 16U) % 8U) * 31U) + (x % 64U));
+    }
+
+    // Ensure every block round-trips
+    const auto compressedBuffer = buffer.compress();
+    assert(
+        compressedBuffer.has_value() &&
+        compressedBuffer->size() < buffer.size());
+    const auto decompressedBuffer = compressedBuffer->decompress();
+    assert(
+        decompressedBuffer.has_value() &&
+        decompressedBuffer->size() == buffer.size() &&
+        decompressedBuffer->hash() == buffer.hash());
+
+    // Ensure truncated data is rejected
+    const auto truncatedBuffer = compressedBuffer->subrange(
+        0ULL, compressedBuffer->size() - 16ULL);
+    assert(!Buffer::decompress(truncatedBuffer));
+
+    // Ensure block counts that only match after overflowing are rejected
+    Buffer overflowBuffer;
+    const char blocksTitle[16ULL] = "yatta blocks";
+    overflowBuffer.push_raw(blocksTitle, sizeof(blocksTitle));
+    overflowBuffer.push_type(std::numeric_limits<size_t>::max());
+    overflowBuffer.push_type(2ULL);
+    overflowBuffer.push_type(0ULL);
+    assert(!Buffer::decompress(overflowBuffer));
+
+    // Ensure block sizes other than the format's are rejected
+    Buffer blockSizeBuffer;
+    blockSizeBuffer.push_raw(blocksTitle, sizeof(blocksTitle));
+    blockSizeBuffer.push_type(4ULL);
+    blockSizeBuffer.push_type(4ULL);
+    blockSizeBuffer.push_type(1ULL);
+    blockSizeBuffer.push_type(1ULL);
+    blockSizeBuffer.push_type(static_cast<std::byte>(0x40U));
+    assert(!Buffer::decompress(blockSizeBuffer));
+
+    // Ensure sizes the compressed blocks could never fill are rejected before
+    // anything is allocated for them
+    Buffer oversizedBuffer;
+    oversizedBuffer.push_raw(blocksTitle, sizeof(blocksTitle));
+    oversizedBuffer.push_type(1ULL << 40U);
+    oversizedBuffer.push_type(1048576ULL);
+    oversizedBuffer.push_type(1048576ULL);
+    for (size_t block = 1ULL; block <= 1048576ULL; ++block)
+        oversizedBuffer.push_type(block);
+    oversizedBuffer.resize(oversizedBuffer.size() + 1048576ULL);
+    assert(!Buffer::decompress(oversizedBuffer));
+
+    // Ensure blocks compressed as far as LZ4 allows still round-trip
+    const Buffer zeroBuffer(3145728ULL, Buffer::Init::Zeroed);
+    const auto zeroCompressed = zeroBuffer.compress(yatta::MaxCompression);
+    assert(zeroCompressed.has_value());
+    const auto zeroDecompressed = zeroCompressed->decompress();
+    assert(
+        zeroDecompressed.has_value() &&
+        zeroDecompressed->hash() == zeroBuffer.hash());
+
+    // Ensure the legacy single block format can still be decompressed
+    Buffer legacyBuffer;
+    const char legacyTitle[16ULL] = "yatta compress";
+    legacyBuffer.push_raw(legacyTitle, sizeof(legacyTitle));
+    legacyBuffer.push_type(5ULL);
+    legacyBuffer.push_type(static_cast<std::byte>(0x50U));
+    legacyBuffer.push_raw("hello", 5ULL);
+    const auto legacyResult = legacyBuffer.decompress();
+    assert(
+        legacyResult.has_value() && legacyResult->size() == 5ULL &&
+        std::memcmp(legacyResult->bytes(), "hello", 5ULL) == 0);
+}
+
+void Buffer_HighCompressionTest() {
+    // Fill a buffer with words in random order
+    constexpr const char* words[8ULL] = { "patch ", "delta ",   "yatta ",
+                                          "file ",  "buffer ",  "range ",
+                                          "hash ",  "compress " };
+    Buffer buffer;
+    unsigned int seed(13579U);
+    for (size_t x = 0ULL; x < 200000ULL; ++x) {
+        seed = (seed * 1103515245U) + 12345U;
+        const auto* word = words[(seed >> 16U) % 8U];
+        buffer.push_raw(word, std::strlen(word));
+    }
+
+    // Ensure higher levels round-trip, without losing ratio
+    const auto fastBuffer = buffer.compress(yatta::FastCompression);
+    const auto highBuffer = buffer.compress(4);
+    const auto maxBuffer = buffer.compress(yatta::MaxCompression);
+    assert(fastBuffer && highBuffer && maxBuffer);
+    assert(
+        highBuffer->size() < fastBuffer->size() &&
+        maxBuffer->size() <= highBuffer->size());
+    for (const auto* compressedBuffer : { &*highBuffer, &*maxBuffer }) {
+        const auto decompressedBuffer = compressedBuffer->decompress();
+        assert(
+            decompressedBuffer.has_value() &&
+            decompressedBuffer->size() == buffer.size() &&
+            decompressedBuffer->hash() == buffer.hash());
+    }
+
+    // Ensure tiny buffers, held entirely as literals, round-trip
+    Buffer tinyBuffer;
+    tinyBuffer.push_raw("tiny", 4ULL);
+    const auto tinyResult = tinyBuffer.compress(yatta::MaxCompression);
+    assert(tinyResult.has_value());
+    const auto tinyDecompressed = tinyResult->decompress();
+    assert(
+        tinyDecompressed.has_value() &&
+        tinyDecompressed->hash() == tinyBuffer.hash());
+
+    // Ensure every level round-trips long runs, noise, and block boundaries
+    Buffer edgeBuffer(2621440ULL, Buffer::Init::Zeroed);
+    for (size_t x = 1572864ULL; x < edgeBuffer.size(); ++x) {
+        seed = (seed * 1103515245U) + 12345U;
+        edgeBuffer[x] = static_cast<std::byte>(seed >> 16U);
+    }
+    for (int level = yatta::FastCompression; level <= yatta::MaxCompression;
+         ++level) {
+        const auto edgeResult = edgeBuffer.compress(level);
+        assert(edgeResult.has_value());
+        const auto edgeDecompressed = edgeResult->decompress();
+        assert(
+            edgeDecompressed.has_value() &&
+            edgeDecompressed->size() == edgeBuffer.size() &&
+            edgeDecompressed->hash() == edgeBuffer.hash());
+    }
+
+    // Ensure buffers around the minimum match size round-trip
+    for (size_t size = 1ULL; size <= 24ULL; ++size) {
+        const Buffer shortBuffer(size, Buffer::Init::Zeroed);
+        const auto shortResult = shortBuffer.compress(yatta::MaxCompression);
+        assert(shortResult.has_value());
+        const auto shortDecompressed = shortResult->decompress();
+        assert(
+            shortDecompressed.has_value() &&
+            shortDecompressed->hash() == shortBuffer.hash());
+    }
+}
+
 void Buffer_DiffTest() {
     // Ensure we cannot diff or patch an empty or incorrect buffer
     Buffer bufferA;
@@ -220,4 +426,288 @@ void Buffer_DiffTest() {
     TestStructureB dataC;
     patchedBuffer->out_type(dataC);
     assert(dataB == dataC && patchedBuffer->hash() == bufferB.hash());
-}
\ No newline at end of file
+}
+
+void Buffer_ShiftedDiffTest() {
+    // Fill a buffer with noise that won't compress on its own
+    Buffer bufferA(65536ULL);
+    unsigned int seed(12345U);
+    for (auto& byte : bufferA) {
+        seed = (seed * 1103515245U) + 12345U;
+        byte = static_cast<std::byte>(seed >> 16U);
+    }
+
+    // Insert a byte near the start, shifting everything after it
+    Buffer bufferB;
+    bufferB.push_raw(bufferA.bytes(), 10ULL);
+    bufferB.push_type(static_cast<std::byte>(42U));
+    bufferB.push_raw(&bufferA[10ULL], bufferA.size() - 10ULL);
+
+    // Ensure the shifted content is matched, keeping the diff small
+    const auto diffBuffer = bufferA.diff(bufferB);
+    assert(diffBuffer.has_value() && diffBuffer->size() < 1024ULL);
+
+    // Ensure the patch reproduces the shifted buffer
+    const auto patchedBuffer = bufferA.patch(*diffBuffer);
+    assert(
+        patchedBuffer.has_value() &&
+        patchedBuffer->size() == bufferB.size() &&
+        patchedBuffer->hash() == bufferB.hash());
+}
+
+void Buffer_SuffixDiffTest() {
+    // Fill a buffer with noise that won't compress on its own
+    Buffer bufferA(65536ULL);
+    unsigned int seed(54321U);
+    for (auto& byte : bufferA) {
+        seed = (seed * 1103515245U) + 12345U;
+        byte = static_cast<std::byte>(seed >> 16U);
+    }
+
+    // Move the second half in front of the first, and alter scattered bytes
+    Buffer bufferB;
+    bufferB.push_raw(&bufferA[32768ULL], 32768ULL);
+    bufferB.push_raw(bufferA.bytes(), 32768ULL);
+    for (size_t x = 100ULL; x < bufferB.size(); x += 100ULL)
+        bufferB[x] = static_cast<std::byte>(~static_cast<unsigned int>(bufferB[x]));
+
+    // Ensure both suffix array modes generate working, compact patches
+    for (const auto approximate : { false, true }) {
+        yatta::DiffOptions options;
+        options.m_method = yatta::DiffOptions::Method::SuffixArray;
+        options.m_approximate = approximate;
+        const auto diffBuffer = bufferA.diff(bufferB, options);
+        assert(diffBuffer.has_value() && diffBuffer->size() < 32768ULL);
+
+        const auto patchedBuffer = bufferA.patch(*diffBuffer);
+        assert(
+            patchedBuffer.has_value() &&
+            patchedBuffer->size() == bufferB.size() &&
+            patchedBuffer->hash() == bufferB.hash());
+    }
+}
+
+void Buffer_ApproximateDiffTest() {
+    // Fill a buffer spanning a few compression blocks with noise, like code
+    // holding an address every 64 bytes
+    Buffer bufferA(1310720ULL);
+    unsigned int seed(4721U);
+    for (auto& byte : bufferA) {
+        seed = (seed * 1103515245U) + 12345U;
+        byte = static_cast<std::byte>(seed >> 16U);
+    }
+
+    // Relocate every address, as if the code it points to was moved
+    Buffer bufferB(bufferA);
+    for (size_t x = 60ULL; x + 4ULL <= bufferB.size(); x += 64ULL) {
+        uint32_t address(0U);
+        bufferA.out_type(address, x);
+        bufferB.in_type(address + 0x1000U, x);
+    }
+
+    // Ensure approximate matches make a far smaller patch than exact ones
+    yatta::DiffOptions options;
+    options.m_method = yatta::DiffOptions::Method::SuffixArray;
+    const auto exactDiff = bufferA.diff(bufferB, options);
+    options.m_approximate = true;
+    const auto approximateDiff = bufferA.diff(bufferB, options);
+    assert(
+        exactDiff.has_value() && approximateDiff.has_value() &&
+        approximateDiff->size() * 4ULL < exactDiff->size());
+
+    // Ensure the patch applies in memory, and streamed across blocks
+    const auto patchedBuffer = bufferA.patch(*approximateDiff);
+    assert(
+        patchedBuffer.has_value() && patchedBuffer->hash() == bufferB.hash());
+    Buffer streamedBuffer;
+    [[maybe_unused]] const auto sink = [&](const MemoryRange& range) {
+        streamedBuffer.push_raw(range.bytes(), range.size());
+        return true;
+    };
+    assert(Buffer::patch(bufferA, *approximateDiff, sink));
+    assert(streamedBuffer.hash() == bufferB.hash());
+}
+
+void Buffer_LargePatchTest() {
+    // Fill a buffer spanning several patch stripes with noise
+    Buffer bufferA(4194304ULL);
+    unsigned int seed(11235U);
+    for (auto& byte : bufferA) {
+        seed = (seed * 1103515245U) + 12345U;
+        byte = static_cast<std::byte>(seed >> 16U);
+    }
+
+    // Shift the content, then scatter some new data and repeats throughout
+    Buffer bufferB;
+    bufferB.push_raw("shift", 5ULL);
+    bufferB.push_raw(bufferA.bytes(), bufferA.size());
+    for (size_t x = 1000ULL; x + 300ULL < bufferB.size(); x += 700000ULL) {
+        std::fill(&bufferB[x], &bufferB[x + 100ULL], std::byte{ 9 });
+        bufferB[x + 200ULL] ^= std::byte{ 0xFF };
+    }
+
+    // Ensure the patch reproduces the target across stripe boundaries
+    const auto diffBuffer = bufferA.diff(bufferB);
+    assert(diffBuffer.has_value());
+    const auto patchedBuffer = bufferA.patch(*diffBuffer);
+    assert(
+        patchedBuffer.has_value() &&
+        patchedBuffer->size() == bufferB.size() &&
+        patchedBuffer->hash() == bufferB.hash());
+}
+
+void Buffer_LegacyPatchTest() {
+    // Write instructions in the legacy format, with fixed-size attributes,
+    // out of order, and padded with empty opcodes
+    Buffer instructionBuffer;
+    instructionBuffer.push_type('R');
+    instructionBuffer.push_type(10ULL);
+    instructionBuffer.push_type(3ULL);
+    instructionBuffer.push_type(static_cast<std::byte>('!'));
+    instructionBuffer.push_type('I');
+    instructionBuffer.push_type(5ULL);
+    instructionBuffer.push_type(5ULL);
+    instructionBuffer.push_raw("hello", 5ULL);
+    instructionBuffer.push_type('\0');
+    instructionBuffer.push_type('C');
+    instructionBuffer.push_type(0ULL);
+    instructionBuffer.push_type(6ULL);
+    instructionBuffer.push_type(11ULL);
+    for (size_t x = 0ULL; x < 7ULL; ++x)
+        instructionBuffer.push_type('\0');
+
+    // Compress them as a single legacy block, within a legacy diff header
+    const char compressTitle[16ULL] = "yatta compress";
+    const char legacyTitle[16ULL] = "yatta diff";
+    const auto bound =
+        LZ4_compressBound(static_cast<int>(instructionBuffer.size()));
+    Buffer compressedBuffer(static_cast<size_t>(bound));
+    const auto compressedSize = LZ4_compress_default(
+        instructionBuffer.charArray(), compressedBuffer.charArray(),
+        static_cast<int>(instructionBuffer.size()), bound);
+    assert(compressedSize > 0);
+    Buffer legacyBuffer;
+    legacyBuffer.push_raw(legacyTitle, sizeof(legacyTitle));
+    legacyBuffer.push_type(13ULL);
+    legacyBuffer.push_raw(compressTitle, sizeof(compressTitle));
+    legacyBuffer.push_type(instructionBuffer.size());
+    legacyBuffer.push_raw(
+        compressedBuffer.bytes(), static_cast<size_t>(compressedSize));
+    Buffer sourceBuffer;
+    sourceBuffer.push_raw("yatta world", 11ULL);
+
+    // Ensure legacy patches can still be applied
+    const auto patchedBuffer = sourceBuffer.patch(legacyBuffer);
+    assert(
+        patchedBuffer.has_value() && patchedBuffer->size() == 13ULL &&
+        std::memcmp(patchedBuffer->bytes(), "worldhello!!!", 13ULL) == 0);
+
+    // Ensure legacy patches can still be streamed, being patched in memory
+    // first as their instructions may be out of order
+    Buffer streamedBuffer;
+    [[maybe_unused]] const auto sink = [&](const MemoryRange& range) {
+        streamedBuffer.push_raw(range.bytes(), range.size());
+        return true;
+    };
+    assert(Buffer::patch(sourceBuffer, legacyBuffer, sink));
+    assert(streamedBuffer.hash() == patchedBuffer->hash());
+
+    // Ensure truncated patches are rejected
+    assert(!Buffer::patch(Buffer(), legacyBuffer.subrange(0ULL, 8ULL)));
+    assert(!Buffer::patch(
+        sourceBuffer, legacyBuffer.subrange(0ULL, legacyBuffer.size() - 1ULL),
+        sink));
+    assert(!Buffer::patch(
+        sourceBuffer, legacyBuffer.subrange(0ULL, 24ULL), sink));
+}
+
+void Buffer_StreamingPatchTest() {
+    // Fill a buffer spanning several patch stripes with noise
+    Buffer bufferA(4194304ULL);
+    unsigned int seed(81321U);
+    for (auto& byte : bufferA) {
+        seed = (seed * 1103515245U) + 12345U;
+        byte = static_cast<std::byte>(seed >> 16U);
+    }
+
+    // Alter the content, appending enough new noise to span several blocks
+    Buffer bufferB(bufferA.size() + 2097152ULL);
+    bufferB.in_raw(bufferA.bytes(), bufferA.size());
+    for (size_t x = bufferA.size(); x < bufferB.size(); ++x) {
+        seed = (seed * 1103515245U) + 12345U;
+        bufferB[x] = static_cast<std::byte>(seed >> 16U);
+    }
+    for (size_t x = 1000ULL; x + 300ULL < bufferA.size(); x += 500000ULL)
+        std::fill(&bufferB[x], &bufferB[x + 100ULL], std::byte{ 9 });
+
+    // Ensure the patched data arrives in order, a piece at a time
+    const auto diffBuffer = bufferA.diff(bufferB);
+    assert(diffBuffer.has_value());
+    Buffer streamedBuffer;
+    size_t pieceCount(0ULL);
+    [[maybe_unused]] const auto sink = [&](const MemoryRange& range) {
+        streamedBuffer.push_raw(range.bytes(), range.size());
+        return ++pieceCount > 0ULL;
+    };
+    assert(Buffer::patch(bufferA, *diffBuffer, sink));
+    assert(
+        pieceCount > 1ULL && streamedBuffer.size() == bufferB.size() &&
+        streamedBuffer.hash() == bufferB.hash());
+
+    // Ensure a failing sink aborts the patch
+    assert(!Buffer::patch(
+        bufferA, *diffBuffer, [](const MemoryRange&) { return false; }));
+
+    // Ensure corrupt patches are rejected
+    assert(!Buffer::patch(
+        bufferA, diffBuffer->subrange(0ULL, diffBuffer->size() / 2ULL), sink));
+
+    // Ensure patches claiming oversized blocks are rejected
+    Buffer oversizedBuffer;
+    const char patchTitle[16ULL] = "yatta patch";
+    const char blocksTitle[16ULL] = "yatta blocks";
+    oversizedBuffer.push_raw(patchTitle, sizeof(patchTitle));
+    oversizedBuffer.push_type(2ULL);
+    oversizedBuffer.push_type(1ULL);
+    oversizedBuffer.push_raw(blocksTitle, sizeof(blocksTitle));
+    oversizedBuffer.push_type(1ULL);
+    oversizedBuffer.push_type(
+        static_cast<size_t>(std::numeric_limits<int>::max()));
+    oversizedBuffer.push_type(1ULL);
+    oversizedBuffer.push_type(1ULL);
+    oversizedBuffer.push_type(std::byte{ 0 });
+    assert(!Buffer::patch(bufferA, oversizedBuffer, sink));
+}
+
+void Buffer_ResourceTest() {
+    // Ensure buffers allocate from the resource they are given
+    CountingResource counter;
+    Buffer buffer(&counter);
+    buffer.resize(1234ULL);
+    assert(buffer.resource() == &counter && counter.m_allocations == 1ULL);
+
+    // Ensure moving carries the resource along, whereas copying does not
+    const Buffer copyBuffer(buffer);
+    assert(copyBuffer.resource() == std::pmr::get_default_resource());
+    const Buffer moveBuffer(std::move(buffer));
+    assert(moveBuffer.resource() == &counter);
+
+    // Ensure diffing and patching draw from an arena
+    Buffer bufferA(65536ULL);
+    for (size_t x = 0ULL; x < bufferA.size(); ++x)
+        bufferA[x] = static_cast<std::byte>((x * 7ULL) % 251ULL);
+    Buffer bufferB(bufferA);
+    bufferB.push_raw("hello world", 11ULL);
+    std::pmr::monotonic_buffer_resource arena(&counter);
+    yatta::DiffOptions options;
+    options.m_resource = &arena;
+    [[maybe_unused]] const auto allocations = counter.m_allocations;
+    const auto diffBuffer = bufferA.diff(bufferB, options);
+    assert(
+        diffBuffer.has_value() && diffBuffer->resource() == &arena &&
+        counter.m_allocations > allocations);
+    const auto patchedBuffer = Buffer::patch(bufferA, *diffBuffer, &arena);
+    assert(
+        patchedBuffer.has_value() && patchedBuffer->resource() == &arena &&
+        patchedBuffer->hash() == bufferB.hash());
+}
@@ -0,0 +1,111 @@
+#include "yatta.hpp"
+#include <cassert>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::Buffer;
+using yatta::MemoryRange;
+using yatta::StreamCompressor;
+using yatta::StreamDecompressor;
+
+// Forward Declarations
+void CompressionStream_RoundTripTest();
+void CompressionStream_EmptyTest();
+void CompressionStream_MalformedTest();
+void CompressionStream_SinkFailureTest();
+
+/** Sink appending every piece it receives to a buffer. */
+auto append_to(Buffer& buffer) {
+    return [&buffer](const MemoryRange& memoryRange) {
+        buffer.push_raw(memoryRange.bytes(), memoryRange.size());
+        return true;
+    };
+}
+
+/** Feed a range to a stream in pieces of an awkward size. */
+template <typename Stream>
+bool write_in_pieces(
+    Stream& stream, const MemoryRange& memoryRange, const size_t& pieceSize) {
+    for (size_t index = 0ULL; index < memoryRange.size(); index += pieceSize) {
+        const auto amount = std::min(pieceSize, memoryRange.size() - index);
+        if (!stream.write(memoryRange.subrange(index, amount)))
+            return false;
+    }
+    return true;
+}
+
+int main() {
+    CompressionStream_RoundTripTest();
+    CompressionStream_EmptyTest();
+    CompressionStream_MalformedTest();
+    CompressionStream_SinkFailureTest();
+    exit(0);
+}
+
+void CompressionStream_RoundTripTest() {
+    // Fill a buffer spanning many chunks, repeating content across them
+    Buffer buffer(1000000ULL);
+    unsigned int seed(97531U);
+    for (size_t x = 0ULL; x < buffer.size(); ++x) {
+        if (x % 32ULL == 0ULL)
+            seed = (seed * 1103515245U) + 12345U;
+        buffer[x] =
+            static_cast<std::byte>((((seed >> 16U) % 64U) * 7U) + (x % 32U));
+    }
+
+    // Ensure the stream compresses
+    Buffer compressedBuffer;
+    StreamCompressor compressor(append_to(compressedBuffer));
+    assert(write_in_pieces(compressor, buffer, 12345ULL));
+    assert(compressor.finish() && !compressor.write(buffer));
+    assert(compressedBuffer.size() < buffer.size());
+
+    // Ensure the stream decompresses, regardless of how it is split up
+    for ([[maybe_unused]] const auto& pieceSize :
+         { 1ULL, 777ULL, 1000000ULL }) {
+        Buffer decompressedBuffer;
+        StreamDecompressor decompressor(append_to(decompressedBuffer));
+        assert(write_in_pieces(decompressor, compressedBuffer, pieceSize));
+        assert(
+            decompressor.isFinished() &&
+            decompressedBuffer.size() == buffer.size() &&
+            decompressedBuffer.hash() == buffer.hash());
+    }
+}
+
+void CompressionStream_EmptyTest() {
+    // Ensure an empty stream still holds a header and an end
+    Buffer compressedBuffer;
+    StreamCompressor compressor(append_to(compressedBuffer));
+    assert(compressor.finish() && compressedBuffer.hasData());
+
+    Buffer decompressedBuffer;
+    StreamDecompressor decompressor(append_to(decompressedBuffer));
+    assert(
+        decompressor.write(compressedBuffer) && decompressor.isFinished() &&
+        !decompressedBuffer.hasData());
+}
+
+void CompressionStream_MalformedTest() {
+    // Ensure a stream without a valid header is rejected
+    Buffer garbage(64ULL);
+    garbage.in_raw("not a stream", 12ULL);
+    Buffer decompressedBuffer;
+    StreamDecompressor decompressor(append_to(decompressedBuffer));
+    assert(!decompressor.write(garbage) && !decompressor.isFinished());
+
+    // Ensure data after the end of a stream is rejected
+    Buffer compressedBuffer;
+    StreamCompressor compressor(append_to(compressedBuffer));
+    assert(compressor.finish());
+    compressedBuffer.push_type(1234ULL);
+    StreamDecompressor trailingDecompressor(append_to(decompressedBuffer));
+    assert(!trailingDecompressor.write(compressedBuffer));
+}
+
+void CompressionStream_SinkFailureTest() {
+    // Ensure a failing sink aborts the stream
+    StreamCompressor compressor([](const MemoryRange&) { return false; });
+    Buffer buffer(200000ULL);
+    assert(!compressor.write(buffer) && !compressor.finish());
+}
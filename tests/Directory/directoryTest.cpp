@@ -1,21 +1,46 @@
 #include "yatta.hpp"
 #include <cassert>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
 // Convenience Definitions
 using yatta::Directory;
+using yatta::Threader;
 
 // Forward Declarations
 void Directory_ConstructionTest();
 void Directory_MethodTest();
 void Directory_CompressionTest();
 void Directory_DeltaTest();
+void Directory_DeterministicDeltaTest();
+void Directory_MoveDeltaTest();
+void Directory_SimilarDeltaTest();
+void Directory_TruncatedTest();
+
+/** Rebuild an archive with its payload cut in half, keeping its header. */
+yatta::Buffer
+truncate_archive(const yatta::Buffer& archive, const size_t& headerSize) {
+    const auto payload = yatta::Buffer::decompress(
+        archive.subrange(headerSize, archive.size() - headerSize));
+    assert(payload.has_value());
+    auto truncated = yatta::Buffer::compress(
+        payload->subrange(0ULL, payload->size() / 2ULL),
+        yatta::FastCompression, std::pmr::get_default_resource(), headerSize);
+    assert(truncated.has_value());
+    std::memcpy(truncated->bytes(), archive.bytes(), headerSize);
+    return std::move(*truncated);
+}
 
 int main() {
     Directory_ConstructionTest();
     Directory_MethodTest();
     Directory_CompressionTest();
     Directory_DeltaTest();
+    Directory_DeterministicDeltaTest();
+    Directory_MoveDeltaTest();
+    Directory_SimilarDeltaTest();
+    Directory_TruncatedTest();
     exit(0);
 }
 
@@ -118,8 +143,24 @@ void Directory_DeltaTest() {
     assert(oldHash != newHash);
 
     // Try to diff the old and new directories
-    const auto deltaBuffer = oldDirectory.out_delta(newDirectory);
+    Directory::DeltaStats stats;
+    const auto deltaBuffer = oldDirectory.out_delta(
+        newDirectory, yatta::FastCompression, std::pmr::get_default_resource(),
+        &stats);
     assert(deltaBuffer.has_value());
+    assert(
+        stats.m_filesUnchanged == 0ULL && stats.m_filesChanged == 3ULL &&
+        stats.m_filesAdded == 1ULL && stats.m_filesRemoved == 1ULL);
+
+    // Ensure a delta against itself skips every file without diffing
+    Directory::DeltaStats selfStats;
+    newDirectory.out_delta(
+        newDirectory, yatta::FastCompression, std::pmr::get_default_resource(),
+        &selfStats);
+    assert(
+        selfStats.m_filesUnchanged == newDirectory.fileCount() &&
+        selfStats.m_filesChanged == 0ULL && selfStats.m_filesAdded == 0ULL &&
+        selfStats.m_filesRemoved == 0ULL);
 
     // Try to patch the old directory into the new directory
     assert(oldDirectory.in_delta(*deltaBuffer));
@@ -133,4 +174,136 @@ void Directory_DeltaTest() {
     assert(
         oldDirectory.fileSize() == 41970ULL &&
         oldDirectory.fileCount() == 4ULL && oldDirectory.hash() == newHash);
-}
\ No newline at end of file
+}
+
+void Directory_DeterministicDeltaTest() {
+    // Ensure deltas are identical regardless of how many threads made them
+    const Directory oldDirectory(Directory::GetRunningDirectory() + "/old");
+    const Directory newDirectory(Directory::GetRunningDirectory() + "/new");
+    Threader::SetSharedThreadCount(1ULL);
+    const auto singleDelta = oldDirectory.out_delta(newDirectory);
+    Threader::SetSharedThreadCount(std::thread::hardware_concurrency());
+    const auto parallelDelta = oldDirectory.out_delta(newDirectory);
+    assert(
+        singleDelta.has_value() && parallelDelta.has_value() &&
+        singleDelta->size() == parallelDelta->size() &&
+        std::memcmp(
+            singleDelta->bytes(), parallelDelta->bytes(),
+            singleDelta->size()) == 0);
+
+    // Ensure arenas that aren't thread-safe can be shared by the parallel diffs
+    std::pmr::monotonic_buffer_resource arena;
+    const auto arenaDelta = oldDirectory.out_delta(
+        newDirectory, yatta::FastCompression, &arena);
+    assert(
+        arenaDelta.has_value() && arenaDelta->size() == parallelDelta->size() &&
+        std::memcmp(
+            arenaDelta->bytes(), parallelDelta->bytes(),
+            arenaDelta->size()) == 0);
+}
+
+void Directory_MoveDeltaTest() {
+    // Reorganize the old folder, renaming a file, moving another, and moving
+    // a third while also modifying it
+    const auto oldPath = Directory::GetRunningDirectory() + "/old";
+    const auto movedPath = Directory::GetRunningDirectory() + "/moved";
+    std::filesystem::remove_all(movedPath);
+    std::filesystem::create_directories(movedPath + "/sub");
+    std::filesystem::copy_file(oldPath + "/0.png", movedPath + "/renamed.png");
+    std::filesystem::copy_file(oldPath + "/1.png", movedPath + "/sub/1.png");
+    std::filesystem::copy_file(oldPath + "/2.png", movedPath + "/sub/2.png");
+    std::filesystem::copy_file(oldPath + "/3.png", movedPath + "/3.png");
+    std::ofstream(movedPath + "/sub/2.png", std::ios::app | std::ios::binary)
+        << "modified";
+
+    // Ensure moved files are detected, rather than deleted and added again
+    Directory oldDirectory(oldPath);
+    const Directory movedDirectory(movedPath);
+    Directory::DeltaStats stats;
+    const auto deltaBuffer = oldDirectory.out_delta(
+        movedDirectory, yatta::FastCompression,
+        std::pmr::get_default_resource(), &stats);
+    assert(
+        deltaBuffer.has_value() && deltaBuffer->size() < 1024ULL &&
+        stats.m_filesMoved == 3ULL && stats.m_filesUnchanged == 1ULL &&
+        stats.m_filesAdded == 0ULL && stats.m_filesRemoved == 0ULL);
+
+    // Ensure the moves can be applied
+    assert(oldDirectory.in_delta(*deltaBuffer));
+    Directory::DeltaStats appliedStats;
+    oldDirectory.out_delta(
+        movedDirectory, yatta::FastCompression,
+        std::pmr::get_default_resource(), &appliedStats);
+    assert(
+        oldDirectory.fileCount() == 4ULL &&
+        appliedStats.m_filesUnchanged == 4ULL);
+    std::filesystem::remove_all(movedPath);
+
+    // Ensure a file sharing only its name with a deleted file isn't moved
+    std::filesystem::create_directories(movedPath + "/sub");
+    std::filesystem::copy_file(
+        Directory::GetRunningDirectory() + "/new/4.png",
+        movedPath + "/sub/0.png");
+    Directory::DeltaStats unrelatedStats;
+    Directory(oldPath).out_delta(
+        Directory(movedPath), yatta::FastCompression,
+        std::pmr::get_default_resource(), &unrelatedStats);
+    assert(
+        unrelatedStats.m_filesMoved == 0ULL &&
+        unrelatedStats.m_filesAdded == 1ULL &&
+        unrelatedStats.m_filesRemoved == 4ULL);
+    std::filesystem::remove_all(movedPath);
+}
+
+void Directory_SimilarDeltaTest() {
+    // Copy the old folder, adding an exact copy of one file and a modified
+    // copy of another under new names
+    const auto oldPath = Directory::GetRunningDirectory() + "/old";
+    const auto similarPath = Directory::GetRunningDirectory() + "/similar";
+    std::filesystem::remove_all(similarPath);
+    std::filesystem::copy(oldPath, similarPath);
+    std::filesystem::copy_file(oldPath + "/2.png", similarPath + "/copy.png");
+    std::filesystem::copy_file(oldPath + "/3.png", similarPath + "/v2.png");
+    std::ofstream(similarPath + "/v2.png", std::ios::app | std::ios::binary)
+        << "modified";
+
+    // Ensure the copies are diffed against their originals, not nothing
+    Directory oldDirectory(oldPath);
+    const Directory similarDirectory(similarPath);
+    Directory::DeltaStats stats;
+    const auto deltaBuffer = oldDirectory.out_delta(
+        similarDirectory, yatta::FastCompression,
+        std::pmr::get_default_resource(), &stats);
+    assert(
+        deltaBuffer.has_value() && deltaBuffer->size() < 1024ULL &&
+        stats.m_filesSimilar == 2ULL && stats.m_filesUnchanged == 4ULL &&
+        stats.m_filesAdded == 0ULL && stats.m_filesRemoved == 0ULL);
+
+    // Ensure the copies can be applied, keeping their originals
+    assert(oldDirectory.in_delta(*deltaBuffer));
+    assert(
+        oldDirectory.fileCount() == 6ULL &&
+        oldDirectory.hash() == similarDirectory.hash());
+    std::filesystem::remove_all(similarPath);
+}
+
+void Directory_TruncatedTest() {
+    // Build a package and a delta, then damage the records inside them
+    Directory directory(Directory::GetRunningDirectory() + "/old");
+    const Directory newDirectory(Directory::GetRunningDirectory() + "/new");
+    [[maybe_unused]] const auto oldHash = directory.hash();
+    const auto package = directory.out_package("package");
+    const auto deltaBuffer = directory.out_delta(newDirectory);
+    assert(package.has_value() && deltaBuffer.has_value());
+    const auto packageHeaderSize = 16ULL + (sizeof(size_t) * 2ULL) + 7ULL;
+    const auto deltaHeaderSize = 16ULL + (sizeof(size_t) * 2ULL);
+    [[maybe_unused]] const auto truncatedPackage =
+        truncate_archive(*package, packageHeaderSize);
+    [[maybe_unused]] const auto truncatedDelta =
+        truncate_archive(*deltaBuffer, deltaHeaderSize);
+
+    // Ensure truncated packages and deltas fail, leaving the files untouched
+    assert(!directory.in_package(truncatedPackage));
+    assert(!directory.in_delta(truncatedDelta));
+    assert(directory.fileCount() == 4ULL && directory.hash() == oldHash);
+}
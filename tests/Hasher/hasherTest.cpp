@@ -0,0 +1,123 @@
+#include "yatta.hpp"
+#include <cassert>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::Buffer;
+using yatta::Hasher;
+using yatta::HashVersion;
+using yatta::MemoryRange;
+using yatta::SharedRange;
+
+// Forward Declarations
+void Hasher_StreamingTest();
+void Hasher_LegacyTest();
+void Hasher_ResetTest();
+void Hasher_CacheTest();
+
+/** Fill a buffer with a non-repeating pattern. */
+Buffer make_buffer(const size_t& size) {
+    Buffer buffer(size, Buffer::Init::Uninitialized);
+    for (size_t x = 0ULL; x < size; ++x)
+        buffer[x] = static_cast<std::byte>((x * 31ULL) % 253ULL);
+    return buffer;
+}
+
+/** Hash a range in pieces of a given size. */
+size_t hash_in_pieces(
+    const MemoryRange& range, const size_t& pieceSize,
+    const HashVersion& version) {
+    Hasher hasher(version);
+    for (size_t offset = 0ULL; offset < range.size(); offset += pieceSize)
+        hasher.update(range.subrange(
+            offset, std::min(pieceSize, range.size() - offset)));
+    return hasher.finalize();
+}
+
+int main() {
+    Hasher_StreamingTest();
+    Hasher_LegacyTest();
+    Hasher_ResetTest();
+    Hasher_CacheTest();
+    exit(0);
+}
+
+void Hasher_StreamingTest() {
+    // Ensure hashing in pieces matches hashing in one pass, for small ranges
+    // and those large enough to be tree-hashed
+    for (const auto& size :
+         { 0ULL, 1ULL, 16ULL, 17ULL, 240ULL, 241ULL, 256ULL, 257ULL, 1000ULL,
+           1024ULL, 1025ULL, 4194304ULL, 4194305ULL, 9000001ULL }) {
+        const auto buffer = make_buffer(size);
+        [[maybe_unused]] const auto expected = buffer.hash();
+        for (const auto& pieceSize :
+             { 1ULL, 7ULL, 64ULL, 300ULL, 65536ULL, size }) {
+            if (pieceSize == 0ULL || (size > 65536ULL && pieceSize < 32ULL))
+                continue;
+            assert(
+                hash_in_pieces(buffer, pieceSize, HashVersion::Current) ==
+                expected);
+        }
+    }
+
+    // Ensure raw pointers can be hashed too
+    const std::string string("abc");
+    Hasher hasher;
+    hasher.update(string.data(), string.size());
+    assert(hasher.finalize() == 0x78AF5F94892F3950ULL);
+}
+
+void Hasher_LegacyTest() {
+    // Ensure legacy hashes match in pieces too, despite hashing whole words
+    const auto buffer = make_buffer(1234ULL);
+    [[maybe_unused]] const auto expected = buffer.hash(HashVersion::Legacy);
+    for ([[maybe_unused]] const auto& pieceSize :
+         { 1ULL, 3ULL, 8ULL, 13ULL, 1234ULL })
+        assert(
+            hash_in_pieces(buffer, pieceSize, HashVersion::Legacy) ==
+            expected);
+}
+
+void Hasher_ResetTest() {
+    // Ensure a hasher can keep going after finalizing, or start over
+    const auto buffer = make_buffer(100ULL);
+    Hasher hasher;
+    hasher.update(buffer.subrange(0ULL, 50ULL));
+    [[maybe_unused]] const auto halfHash = hasher.finalize();
+    assert(halfHash == buffer.subrange(0ULL, 50ULL).hash());
+    hasher.update(buffer.subrange(50ULL, 50ULL));
+    assert(hasher.finalize() == buffer.hash());
+    hasher.reset();
+    hasher.update(buffer.subrange(0ULL, 50ULL));
+    assert(hasher.finalize() == halfHash);
+}
+
+void Hasher_CacheTest() {
+    // Ensure shared ranges cache their hash, and pass it along to copies
+    auto buffer = make_buffer(5000ULL);
+    [[maybe_unused]] const auto expected = buffer.hash();
+    auto* const data = buffer.bytes();
+    const SharedRange sharedRange(std::move(buffer));
+    assert(sharedRange.hash() == expected);
+    const SharedRange copyRange(sharedRange);
+    assert(copyRange.hash() == expected);
+    [[maybe_unused]] const MemoryRange& baseRange = sharedRange;
+
+    // Ensure later calls don't rehash, even through the base class, by
+    // changing the memory underneath the cache from its original owner
+    data[0] = ~data[0];
+    assert(Hasher::Hash(sharedRange) != expected);
+    assert(sharedRange.hash() == expected && copyRange.hash() == expected);
+    assert(baseRange.hash() == expected);
+    data[0] = ~data[0];
+
+    // Ensure the cache is unaffected by the hash version
+    assert(
+        sharedRange.hash(HashVersion::Legacy) ==
+        Hasher::Hash(sharedRange, HashVersion::Legacy));
+
+    // Ensure slices hash their own contents
+    const auto slice = sharedRange.slice(100ULL, 200ULL);
+    assert(slice.hash() == baseRange.subrange(100ULL, 200ULL).hash());
+    assert(slice.hash() != expected);
+}
@@ -0,0 +1,97 @@
+#include "yatta.hpp"
+#include <cassert>
+#include <fstream>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::Buffer;
+using yatta::Directory;
+using yatta::MappedFile;
+using yatta::MemoryRange;
+using yatta::SharedRange;
+
+// Forward Declarations
+void MappedFile_ConstructionTest();
+void MappedFile_MoveTest();
+void MappedFile_DerivationTest();
+
+int main() {
+    MappedFile_ConstructionTest();
+    MappedFile_MoveTest();
+    MappedFile_DerivationTest();
+    exit(0);
+}
+
+void MappedFile_ConstructionTest() {
+    // Ensure missing files fail to map
+    const MappedFile missingFile(
+        Directory::GetRunningDirectory() + "/old/missing.png");
+    assert(!missingFile.isOpen() && missingFile.empty());
+
+    // Ensure files map with the same contents as when read from disk
+    const auto path = Directory::GetRunningDirectory() + "/old/0.png";
+    const MappedFile mappedFile(path);
+    assert(mappedFile.isOpen() && mappedFile.hasData());
+    Buffer fileBuffer(mappedFile.size());
+    std::ifstream fileOnDisk(path, std::ios_base::in | std::ios_base::binary);
+    fileOnDisk.read(
+        fileBuffer.charArray(),
+        static_cast<std::streamsize>(fileBuffer.size()));
+    assert(mappedFile.hash() == fileBuffer.hash());
+
+    // Ensure empty files map to an empty range
+    const auto emptyPath =
+        std::filesystem::temp_directory_path() / "yatta_empty_mapped_file";
+    std::ofstream(emptyPath).close();
+    const MappedFile emptyFile(emptyPath);
+    assert(emptyFile.isOpen() && emptyFile.empty());
+    std::filesystem::remove(emptyPath);
+}
+
+void MappedFile_MoveTest() {
+    // Ensure mappings move, leaving the source closed
+    MappedFile fileA(Directory::GetRunningDirectory() + "/old/0.png");
+    [[maybe_unused]] const auto hash = fileA.hash();
+    MappedFile fileB(std::move(fileA));
+    assert(!fileA.isOpen() && fileA.empty());
+    assert(fileB.isOpen() && fileB.hash() == hash);
+    fileA = std::move(fileB);
+    assert(fileA.isOpen() && fileA.hash() == hash);
+
+    // Ensure closing empties the range
+    fileA.close();
+    assert(!fileA.isOpen() && fileA.empty());
+}
+
+void MappedFile_DerivationTest() {
+    // Ensure mapped files can be diffed and patched without copying them
+    const MappedFile oldFile(Directory::GetRunningDirectory() + "/old/0.png");
+    const MappedFile newFile(Directory::GetRunningDirectory() + "/new/0.png");
+    const auto diffBuffer = Buffer::diff(oldFile, newFile);
+    assert(diffBuffer.has_value());
+    const auto patchedBuffer = Buffer::patch(oldFile, *diffBuffer);
+    assert(
+        patchedBuffer.has_value() && patchedBuffer->hash() == newFile.hash());
+
+    // Ensure mapped files are only accessible as read-only memory
+    static_assert(!std::is_convertible_v<MappedFile&, MemoryRange&>);
+    [[maybe_unused]] const MemoryRange& oldRange = oldFile;
+    static_assert(
+        std::is_same_v<decltype(oldRange.bytes()), const std::byte*>);
+    assert(
+        oldRange.bytes() == oldFile.bytes() &&
+        oldRange.size() == oldFile.size());
+
+    // Ensure shared ranges can take ownership of mapped files
+    const SharedRange sharedFile(
+        MappedFile(Directory::GetRunningDirectory() + "/new/0.png"));
+    assert(sharedFile.hash() == newFile.hash());
+
+    // Ensure mapped files can be compressed
+    const auto compressedBuffer = Buffer::compress(newFile);
+    assert(compressedBuffer.has_value());
+    const auto decompressedBuffer = compressedBuffer->decompress();
+    assert(
+        decompressedBuffer.has_value() &&
+        decompressedBuffer->hash() == newFile.hash());
+}
@@ -3,13 +3,16 @@
 #include <iostream>
 
 // Convenience Definitions
+using yatta::HashVersion;
 using yatta::MemoryRange;
+using yatta::Threader;
 
 // Forward Declarations
 void MemoryRange_ConstructionTest();
 void MemoryRange_AssignmentTest();
 void MemoryRange_MethodTest();
 void MemoryRange_IOTest();
+void MemoryRange_HashTest();
 void MemoryRange_IndexExceptionTest();
 void MemoryRange_SubrangeExceptionTest();
 void MemoryRange_InOutRaw1ExceptionTest();
@@ -22,6 +25,7 @@ int main() {
     MemoryRange_AssignmentTest();
     MemoryRange_MethodTest();
     MemoryRange_IOTest();
+    MemoryRange_HashTest();
     MemoryRange_IndexExceptionTest();
     MemoryRange_SubrangeExceptionTest();
     MemoryRange_InOutRaw1ExceptionTest();
@@ -98,6 +102,13 @@ void MemoryRange_MethodTest() {
     [[maybe_unused]] const auto bytes = static_cast<void*>(memRange.bytes());
     assert(charArray != nullptr && bytes == charArray);
 
+    // Ensure const ranges only expose their data as read-only
+    [[maybe_unused]] const MemoryRange& constRange = memRange;
+    static_assert(
+        std::is_same_v<decltype(constRange.bytes()), const std::byte*> &&
+        std::is_same_v<decltype(constRange.charArray()), const char*>);
+    assert(constRange.bytes() == memRange.bytes());
+
     // Ensure we can create a valid iterate-able sub-range
     auto subRange = memRange.subrange(0, 617ULL);
     [[maybe_unused]] const auto byteCount =
@@ -362,4 +373,43 @@ void MemoryRange_InOutStringExceptionTest() {
         exceptions[3] = true;
     }
     assert(exceptions[3]);
+}
+
+void MemoryRange_HashTest() {
+    // Ensure hashes match XXH3's reference values, for short, medium and
+    // long inputs
+    std::string string("Nobody inspects the spammish repetition");
+    std::string longString(1000ULL, 'a');
+    const MemoryRange longRange(
+        longString.size(), reinterpret_cast<std::byte*>(longString.data()));
+    const MemoryRange stringRange(
+        string.size(), reinterpret_cast<std::byte*>(string.data()));
+    std::string shortString("abc");
+    const MemoryRange shortRange(
+        shortString.size(), reinterpret_cast<std::byte*>(shortString.data()));
+    assert(stringRange.hash() == 0x6CB00603B5CC47E9ULL);
+    assert(shortRange.hash() == 0x78AF5F94892F3950ULL);
+    assert(shortRange.subrange(0ULL, 0ULL).hash() == 0x2D06800538D394C2ULL);
+    assert(longRange.hash() == 0xB3E7AF627147DB7CULL);
+
+    // Ensure legacy hashes can still be generated
+    assert(
+        stringRange.hash(HashVersion::Legacy) != stringRange.hash() &&
+        stringRange.hash(HashVersion::Legacy) ==
+            stringRange.hash(HashVersion::Legacy));
+
+    // Ensure large ranges hash the same for any number of threads
+    const size_t size = (9ULL * 1024ULL * 1024ULL) + 123ULL;
+    const auto buffer = std::make_unique<std::byte[]>(size);
+    for (size_t x = 0ULL; x < size; ++x)
+        buffer[x] = static_cast<std::byte>((x * 7ULL) % 251ULL);
+    const MemoryRange largeRange(size, buffer.get());
+    Threader::SetSharedThreadCount(1ULL);
+    [[maybe_unused]] const auto singleHash = largeRange.hash();
+    Threader::SetSharedThreadCount(std::thread::hardware_concurrency());
+    assert(largeRange.hash() == singleHash);
+
+    // Ensure a single byte change alters the hash
+    buffer[size / 2ULL] ^= static_cast<std::byte>(1U);
+    assert(largeRange.hash() != singleHash);
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "yatta.hpp"
+#include <cassert>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::Buffer;
+using yatta::MemoryRange;
+using yatta::SharedRange;
+
+// Forward Declarations
+void SharedRange_ConstructionTest();
+void SharedRange_SliceTest();
+void SharedRange_MoveTest();
+
+int main() {
+    SharedRange_ConstructionTest();
+    SharedRange_SliceTest();
+    SharedRange_MoveTest();
+    exit(0);
+}
+
+void SharedRange_ConstructionTest() {
+    // Ensure we can make empty shared ranges
+    const SharedRange emptyRange;
+    assert(emptyRange.empty() && emptyRange.useCount() == 0L);
+
+    // Ensure taking ownership of a buffer keeps its memory in place
+    Buffer buffer(1234ULL);
+    buffer[0] = static_cast<std::byte>(123U);
+    [[maybe_unused]] const auto* const dataPtr = buffer.bytes();
+    const SharedRange sharedRange(std::move(buffer));
+    assert(
+        sharedRange.size() == 1234ULL && sharedRange.bytes() == dataPtr &&
+        sharedRange[0] == static_cast<std::byte>(123U) &&
+        sharedRange.useCount() == 1L);
+
+    // Ensure the memory is only exposed as read-only
+    static_assert(!std::is_convertible_v<SharedRange&, MemoryRange&>);
+    [[maybe_unused]] const MemoryRange& view = sharedRange;
+    static_assert(std::is_same_v<decltype(view.bytes()), const std::byte*>);
+    assert(view.bytes() == dataPtr && view.hash() == sharedRange.hash());
+
+    // Ensure copies share the same memory
+    const SharedRange copyRange(sharedRange);
+    assert(
+        copyRange.bytes() == dataPtr && copyRange.useCount() == 2L &&
+        sharedRange.useCount() == 2L);
+}
+
+void SharedRange_SliceTest() {
+    // Ensure slices alias their parent's memory
+    Buffer buffer;
+    buffer.push_raw("header body", 11ULL);
+    SharedRange sharedRange(std::move(buffer));
+    const auto body = sharedRange.slice(7ULL, 4ULL);
+    assert(
+        body.size() == 4ULL && body.bytes() == &sharedRange.bytes()[7] &&
+        std::memcmp(body.bytes(), "body", 4ULL) == 0);
+
+    // Ensure slices keep the memory alive after their parent is released
+    sharedRange.reset();
+    assert(sharedRange.empty() && body.useCount() == 1L);
+    assert(std::memcmp(body.bytes(), "body", 4ULL) == 0);
+
+    // Ensure slicing out of range throws
+    [[maybe_unused]] bool threw(false);
+    try {
+        const auto badSlice = body.slice(2ULL, 4ULL);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void SharedRange_MoveTest() {
+    // Ensure moving transfers ownership, leaving the source empty
+    SharedRange sharedRange(Buffer(64ULL));
+    [[maybe_unused]] const auto* const dataPtr = sharedRange.bytes();
+    SharedRange moveRange(std::move(sharedRange));
+    assert(
+        moveRange.bytes() == dataPtr && moveRange.useCount() == 1L &&
+        sharedRange.empty());
+    sharedRange = std::move(moveRange);
+    assert(
+        sharedRange.bytes() == dataPtr && sharedRange.useCount() == 1L &&
+        moveRange.empty());
+
+    // Ensure shared ranges can be used wherever memory ranges are
+    const MemoryRange& memoryRange = sharedRange;
+    const auto compressed = Buffer::compress(memoryRange);
+    assert(compressed.has_value());
+}
@@ -0,0 +1,118 @@
+#include "yatta.hpp"
+#include <cassert>
+#include <iostream>
+
+// Convenience Definitions
+using yatta::TaskGroup;
+using yatta::Threader;
+
+// Forward Declarations
+void Threader_SubmitTest();
+void Threader_TaskGroupTest();
+void Threader_NestedTaskGroupTest();
+void Threader_TaskGroupExceptionTest();
+void Threader_ParallelForTest();
+void Threader_ParallelReduceTest();
+
+int main() {
+    Threader_SubmitTest();
+    Threader_TaskGroupTest();
+    Threader_NestedTaskGroupTest();
+    Threader_TaskGroupExceptionTest();
+    Threader_ParallelForTest();
+    Threader_ParallelReduceTest();
+    exit(0);
+}
+
+void Threader_SubmitTest() {
+    // Ensure futures hold the job's result
+    Threader threader;
+    auto future = threader.submit([]() { return 1234ULL; });
+    assert(future.get() == 1234ULL);
+
+    // Ensure futures hold the job's exception
+    auto failed = threader.submit([]() -> int {
+        throw std::runtime_error("submit test");
+    });
+    try {
+        failed.get();
+        assert(false);
+    } catch (const std::runtime_error&) {
+        // Expected
+    }
+}
+
+void Threader_TaskGroupTest() {
+    // Ensure a group waits on all of its jobs
+    Threader threader;
+    std::atomic_size_t counter(0ULL);
+    TaskGroup group(threader);
+    for (size_t x = 0ULL; x < 1000ULL; ++x)
+        group.run([&counter]() { counter++; });
+    group.wait();
+    assert(counter == 1000ULL);
+}
+
+void Threader_NestedTaskGroupTest() {
+    // Ensure groups waited on from within jobs don't starve the threader
+    Threader threader(2ULL);
+    std::atomic_size_t counter(0ULL);
+    TaskGroup outer(threader);
+    for (size_t x = 0ULL; x < 16ULL; ++x)
+        outer.run([&]() {
+            TaskGroup inner(threader);
+            for (size_t y = 0ULL; y < 64ULL; ++y)
+                inner.run([&counter]() { counter++; });
+            inner.wait();
+        });
+    outer.wait();
+    assert(counter == 1024ULL);
+}
+
+void Threader_TaskGroupExceptionTest() {
+    // Ensure a group rethrows a job's exception once
+    Threader threader;
+    TaskGroup group(threader);
+    group.run([]() { throw std::runtime_error("task group test"); });
+    try {
+        group.wait();
+        assert(false);
+    } catch (const std::runtime_error&) {
+        // Expected
+    }
+    group.wait();
+}
+
+void Threader_ParallelForTest() {
+    // Ensure every index is visited exactly once
+    Threader threader;
+    std::vector<size_t> values(10000ULL, 0ULL);
+    threader.parallel_for(
+        0ULL, values.size(), [&](const size_t& index) { values[index]++; });
+    assert(std::all_of(values.cbegin(), values.cend(), [](const auto& value) {
+        return value == 1ULL;
+    }));
+
+    // Ensure empty ranges do nothing
+    threader.parallel_for(10ULL, 10ULL, [](const size_t&) { assert(false); });
+}
+
+void Threader_ParallelReduceTest() {
+    // Ensure ranges reduce to the expected value
+    Threader threader;
+    [[maybe_unused]] const auto sum = threader.parallel_reduce(
+        1ULL, 10001ULL, 0ULL, [](const size_t& index) { return index; },
+        [](const size_t& a, const size_t& b) { return a + b; });
+    assert(sum == 50005000ULL);
+
+    // Ensure chunks are combined in order, regardless of the grain size
+    const auto map = [](const size_t& index) { return std::to_string(index); };
+    const auto reduce = [](const std::string& a, const std::string& b) {
+        return a + b;
+    };
+    const auto fine =
+        threader.parallel_reduce(0ULL, 100ULL, std::string(), map, reduce, 1ULL);
+    const auto coarse = threader.parallel_reduce(
+        0ULL, 100ULL, std::string(), map, reduce, 100ULL);
+    assert(fine == coarse);
+}